@@ -0,0 +1,223 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+#include <cmath>
+
+#include "area_filter.h"
+#include "mipmap.h"
+
+void buildSourcePyramid(const QImage& source, ThreadPool& pool, SourcePyramid& pyramid) {
+
+    pyramid.levels.assign(1, source);
+    pyramid.views.assign(1, makeSourceView(source));
+
+    const int depth = source.depth();
+    while (pyramid.views.back().height > 1) {
+
+        const SourceView& src = pyramid.views.back();
+        QImage level(std::max(1, src.width / 2), src.height / 2, source.format());
+        uchar* dst = level.bits();
+        const qsizetype dst_stride = level.bytesPerLine();
+
+        // Bands of destination rows, each reading its own pairs of source rows
+        const int band_rows = 16;
+        const int bands = (level.height() + band_rows - 1) / band_rows;
+        pool.parallelFor(bands, [&](int band) {
+            const int y_begin = band * band_rows;
+            const int src_rows = std::min(2 * band_rows, src.height - 2 * y_begin);
+            downsampleBox(src.bits + 2 * y_begin * src.stride, src.stride, src.width, src_rows,
+                          dst + y_begin * dst_stride, dst_stride, depth);
+        });
+
+        pyramid.levels.push_back(level);
+        pyramid.views.push_back(makeSourceView(pyramid.levels.back()));
+    }
+}
+
+// One weighted tap of a texel, the SamplePoint itself goes in the level's point list
+struct AreaTap {
+    int texel;
+    int weight;     // Out of 256 for the whole texel
+};
+
+// Shortest signed distance between two u positions on a row that wraps around
+static inline float wrapDelta(float delta, float width) {
+    if (delta > 0.5f * width)
+        return delta - width;
+    if (delta < -0.5f * width)
+        return delta + width;
+    return delta;
+}
+
+//
+// Area filtered tile
+//
+// Each texel's footprint comes from the source positions of its right and lower
+// neighbours.  Up to AREA_MAX_TAPS bilinear taps are spread along its longer
+// axis, in the pyramid level where one tap covers the rest of the footprint,
+// blended with the next level down by the fractional part of that level.  Every
+// tap gets an integer weight so a texel's weights add up to exactly 256, then
+// the taps of each level are sampled as one row by the usual kernels and summed
+// into their texels.  A footprint of at most a source pixel is a single
+// weight 256 tap at level 0, exactly what the bilinear filter gives.
+//
+template<typename Pixel, typename RowFunction>
+static void areaTile(const SourcePyramid& pyramid, RowFunction sampleRow, CubeProjection projection,
+                     const FaceTargets& targets, int face, int edge, int tile_x, int tile_y, int tile_size) {
+
+    const int inW = pyramid.views[0].width;
+    const int inH = pyramid.views[0].height;
+    const int levels = static_cast<int>(pyramid.views.size());
+    const int i_end = std::min(tile_x + tile_size, edge);
+    const int j_end = std::min(tile_y + tile_size, edge);
+    const int count = i_end - tile_x;
+
+    // 8-bit channels in QRgb, 16-bit ones in RGBA64
+    const int shift = sizeof(Pixel) * 2;
+    const Pixel mask = (static_cast<Pixel>(1) << shift) - 1;
+
+    // Source positions of this row and the next, one texel past the tile
+    std::vector<float> row_u(count + 1), row_v(count + 1), next_u(count + 1), next_v(count + 1);
+    for (int i = 0; i <= count; ++i)
+        sourcePosition(face, edge, inW, inH, tile_x + i, tile_y, row_u[i], row_v[i], projection);
+
+    std::vector<std::vector<SamplePoint>> points(levels);
+    std::vector<std::vector<AreaTap>> taps(levels);
+    std::vector<Pixel> sampled;
+    std::vector<quint32> sums(count * 3);
+
+    for (int j_face = tile_y; j_face < j_end; ++j_face) {
+
+        for (int i = 0; i <= count; ++i)
+            sourcePosition(face, edge, inW, inH, tile_x + i, j_face + 1, next_u[i], next_v[i], projection);
+
+        for (int level = 0; level < levels; ++level) {
+            points[level].clear();
+            taps[level].clear();
+        }
+
+        for (int i = 0; i < count; ++i) {
+
+            // The footprint's two axes, in source pixels
+            const float across_u = wrapDelta(row_u[i + 1] - row_u[i], static_cast<float>(inW));
+            const float across_v = row_v[i + 1] - row_v[i];
+            const float down_u = wrapDelta(next_u[i] - row_u[i], static_cast<float>(inW));
+            const float down_v = next_v[i] - row_v[i];
+            const float across = std::hypot(across_u, across_v);
+            const float down = std::hypot(down_u, down_v);
+
+            const float major = std::max(across, down);
+            const float minor = std::min(across, down);
+            const float axis_u = (across >= down) ? across_u : down_u;
+            const float axis_v = (across >= down) ? across_v : down_v;
+
+            // Enough taps to cover the long axis at the short axis' scale
+            int tap_count = 1;
+            if (major > 1.0f)
+                tap_count = clip(static_cast<int>(major / std::max(minor, 1.0f) + 0.5f), 1, AREA_MAX_TAPS);
+
+            // The level where one tap covers its share of the footprint, and how far towards the next
+            const float footprint = std::max(minor, major / tap_count);
+            const float lod = (footprint > 1.0f) ? std::log2(footprint) : 0.0f;
+            int level = static_cast<int>(lod);
+            int blend = static_cast<int>((lod - level) * 256.0f + 0.5f);
+            if (blend == 256) {
+                ++level;
+                blend = 0;
+            }
+            if (level >= levels - 1) {
+                level = levels - 1;
+                blend = 0;
+            }
+
+            for (int l = 0; l < 2; ++l) {
+
+                const int level_weight = l ? blend : 256 - blend;
+                if (level_weight == 0)
+                    continue;
+
+                const SourceView& view = pyramid.views[level + l];
+                const float scale_u = static_cast<float>(view.width) / inW;
+                const float scale_v = static_cast<float>(view.height) / inH;
+
+                for (int k = 0; k < tap_count; ++k) {
+
+                    const float s = (k + 0.5f) / tap_count - 0.5f;
+                    float u = row_u[i] + s * axis_u;
+                    float v = row_v[i] + s * axis_v;
+
+                    // Pixel centres of a level sit in the middle of the 2^level pixels they average
+                    if (level + l > 0) {
+                        u = (u + 0.5f) * scale_u - 0.5f;
+                        v = (v + 0.5f) * scale_v - 0.5f;
+                    }
+
+                    points[level + l].push_back(makeSamplePoint(u, v, view.width, view.height));
+                    taps[level + l].push_back({ i, level_weight * (k + 1) / tap_count - level_weight * k / tap_count });
+                }
+            }
+        }
+
+        std::fill(sums.begin(), sums.end(), 0);
+        for (int level = 0; level < levels; ++level) {
+
+            const int tap_total = static_cast<int>(points[level].size());
+            if (tap_total == 0)
+                continue;
+
+            sampled.resize(tap_total);
+            sampleRow(pyramid.views[level], points[level].data(), tap_total, sampled.data());
+
+            for (int t = 0; t < tap_total; ++t) {
+                quint32* sum = &sums[taps[level][t].texel * 3];
+                const quint32 weight = taps[level][t].weight;
+                for (int c = 0; c < 3; ++c)
+                    sum[c] += weight * static_cast<quint32>((sampled[t] >> (c * shift)) & mask);
+            }
+        }
+
+        Pixel* out_line = reinterpret_cast<Pixel*>(targets.bits[face] + j_face * targets.stride) + tile_x;
+        for (int i = 0; i < count; ++i) {
+            Pixel pixel = mask << (3 * shift);
+            for (int c = 0; c < 3; ++c)
+                pixel |= static_cast<Pixel>((sums[i * 3 + c] + 128) >> 8) << (c * shift);
+            out_line[i] = pixel;
+        }
+
+        std::swap(row_u, next_u);
+        std::swap(row_v, next_v);
+    }
+}
+
+void convertTileArea(const SourcePyramid& pyramid, SampleRowFunction sampleRow, CubeProjection projection,
+                     const FaceTargets& targets, int face, int edge, int tile_x, int tile_y, int tile_size) {
+    areaTile<QRgb>(pyramid, sampleRow, projection, targets, face, edge, tile_x, tile_y, tile_size);
+}
+
+void convertTileArea(const SourcePyramid& pyramid, SampleRow64Function sampleRow, CubeProjection projection,
+                     const FaceTargets& targets, int face, int edge, int tile_x, int tile_y, int tile_size) {
+    areaTile<quint64>(pyramid, sampleRow, projection, targets, face, edge, tile_x, tile_y, tile_size);
+}
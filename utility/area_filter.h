@@ -0,0 +1,62 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef AREA_FILTER_HPP
+#define AREA_FILTER_HPP
+
+// C++ and STL includes
+#include <vector>
+
+// Qt includes
+#include <QImage>
+
+#include "thread_pool.h"
+#include "cubemap_sampler.h"
+#include "cubemap_convert.h"
+
+// Most taps the area filter spreads along a texel's footprint, longer
+// footprints (near the poles) read a smaller pyramid level instead
+const int AREA_MAX_TAPS = 8;
+
+//
+// A prefiltered equirectangular source
+//
+// Level 0 is the 32-bit (or RGBA64) source itself, every further level halves
+// the one before with a 2x2 box filter, down to a single row.
+//
+struct SourcePyramid {
+    std::vector<QImage>     levels;
+    std::vector<SourceView> views;
+};
+
+// Build the pyramid of a source already in the sampling kernels' format, rows are spread over the pool
+void buildSourcePyramid(const QImage& source, ThreadPool& pool, SourcePyramid& pyramid);
+
+// Fill one square tile of a face with the area filter, 32-bit or 64-bit faces
+void convertTileArea(const SourcePyramid& pyramid, SampleRowFunction sampleRow, CubeProjection projection,
+                     const FaceTargets& targets, int face, int edge, int tile_x, int tile_y, int tile_size);
+void convertTileArea(const SourcePyramid& pyramid, SampleRow64Function sampleRow, CubeProjection projection,
+                     const FaceTargets& targets, int face, int edge, int tile_x, int tile_y, int tile_size);
+
+#endif // AREA_FILTER_HPP
@@ -0,0 +1,402 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+// Qt includes
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "batch_pipeline.h"
+#include "cubemap_io.h"
+#include "mipmap.h"
+#include "resource_usage.h"
+
+// One image travelling through the pipeline
+struct BatchJob {
+    int     index = 0;
+    QString input_path;
+    QString dds_path;
+    QString png_path;
+    QImage  image;
+    CubemapMips mips;
+    CompressedCubemap compressed;
+    Ktx2Cubemap supercompressed;
+    qint64  input_bytes = 0;        // Reserved for the decoded input
+    qint64  output_bytes = 0;       // Reserved for the unfolded cubemap or face stack and its mips
+    qint64  pixels = 0;
+    int     edge = 0;               // Face edge from the full size of a JPEG, which may decode smaller
+    bool    ok = true;
+};
+
+typedef std::chrono::steady_clock BatchClock;
+
+static double secondsSince(BatchClock::time_point start) {
+    return std::chrono::duration<double>(BatchClock::now() - start).count();
+}
+
+void MemoryBudget::acquire(qint64 bytes) {
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_limit > 0)
+        m_released.wait(lock, [this, bytes] { return m_in_use == 0 || m_in_use + bytes <= m_limit; });
+
+    m_in_use += bytes;
+    m_peak = std::max(m_peak, m_in_use);
+}
+
+void MemoryBudget::release(qint64 bytes) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_in_use -= bytes;
+    m_released.notify_all();
+}
+
+// Is this a file the batch should pick up from a directory?
+static bool isBatchImage(const QFileInfo& info, bool unfolded) {
+
+    const QString extension = info.suffix().toLower();
+    if (extension == "dng" || extension == "jpg" || extension == "jpeg" || extension == "tif" || extension == "tiff")
+        return true;
+
+    // Converting writes a PNG next to every input, so PNGs are only inputs when they're unfolded cubemaps
+    return unfolded && extension == "png";
+}
+
+QStringList collectBatchInputs(const QStringList& arguments, bool unfolded) {
+
+    QStringList inputs;
+
+    for (const QString& argument : arguments) {
+
+        // @file holds one image path per line
+        if (argument.startsWith("@")) {
+            QFile list(argument.mid(1));
+            if (!list.open(QIODevice::ReadOnly)) {
+                std::cerr << "Could not open file list: " << argument.mid(1).toStdString() << std::endl;
+                continue;
+            }
+            while (!list.atEnd()) {
+                const QString line = QString::fromUtf8(list.readLine()).trimmed();
+                if (!line.isEmpty() && !line.startsWith("#"))
+                    inputs.push_back(line);
+            }
+            continue;
+        }
+
+        // A directory contributes its images in name order
+        QFileInfo info(argument);
+        if (info.isDir()) {
+            for (const QFileInfo& entry : QDir(argument).entryInfoList(QStringList(), QDir::Files, QDir::Name)) {
+                if (isBatchImage(entry, unfolded))
+                    inputs.push_back(entry.filePath());
+            }
+            continue;
+        }
+
+        inputs.push_back(argument);
+    }
+
+    return inputs;
+}
+
+// Rough size of everything a job allocates for an input of this size
+static void estimateJobBytes(QSize size, const BatchOptions& options, qint64& input_bytes, qint64& output_bytes) {
+
+    // Previews are scaled down as they load
+    if (options.preview && size.width() > PREVIEW_WIDTH)
+        size = QSize(PREVIEW_WIDTH, size.height() * PREVIEW_WIDTH / size.width());
+
+    const qint64 pixels = static_cast<qint64>(size.width()) * size.height();
+    const qint64 edge = cubemapEdge(size.width(), options.edge_percent);
+
+    // High bit depth images take 16 bits per channel all the way through
+    const qint64 pixel_bytes = options.hdr ? 8 : 4;
+
+    // The decoded input plus the copy the sampling kernels read
+    input_bytes = options.unfolded ? 0 : pixels * pixel_bytes * 2;
+
+    // The DDS is written straight from the unfolded cubemap or the face stack,
+    // only the cross has cells that aren't faces
+    int columns = 1, rows = 6;
+    if (options.write_png)
+        cubemapLayoutGrid(options.layout, columns, rows);
+    if (options.unfolded)
+        output_bytes = pixels * pixel_bytes;
+    else
+        output_bytes = columns * rows * edge * edge * pixel_bytes;
+
+    // The mip chains of the six faces add up to a third of the faces themselves
+    if (options.mipmaps)
+        output_bytes += 2 * edge * edge * pixel_bytes;
+
+    // Compressed blocks take at most one byte per pixel
+    if (options.block_format != BlockFormat::None)
+        output_bytes += (options.mipmaps ? 8 : 6) * edge * edge;
+}
+
+int runBatch(const QStringList& inputs, const BatchOptions& options, ThreadPool& pool) {
+
+    const int total = static_cast<int>(inputs.size());
+    std::cout << "Batch of " << total << " images" << std::endl;
+
+    MemoryBudget budget(options.memory_limit);
+    BoundedQueue<std::unique_ptr<BatchJob>> decoded(1);
+    BoundedQueue<std::unique_ptr<BatchJob>> converted(1);
+
+    // Busy time of each stage, only touched by that stage's thread
+    double decode_seconds = 0.0;
+    double convert_seconds = 0.0;
+    double encode_seconds = 0.0;
+    qint64 total_pixels = 0;
+    int failed = 0;
+
+    const BatchClock::time_point batch_start = BatchClock::now();
+
+    // Stage 1: decode, as far ahead as the memory limit allows
+    std::thread decoder([&] {
+
+        for (int index = 0; index < total; ++index) {
+
+            std::unique_ptr<BatchJob> job(new BatchJob);
+            job->index = index;
+            job->input_path = inputs[index];
+
+            QFileInfo file_info(job->input_path);
+            QString path_no_extension = file_info.path() + "/" + file_info.completeBaseName();
+            if (options.preview)
+                path_no_extension += "_preview";
+            job->dds_path = path_no_extension + (options.ktx2 ? ".ktx2" : ".dds");
+            job->png_path = path_no_extension + ".png";
+
+            // Hold back until this image fits in the memory limit
+            const QSize size = probeImageSize(job->input_path);
+            if (size.isValid())
+                estimateJobBytes(size, options, job->input_bytes, job->output_bytes);
+            budget.acquire(job->input_bytes + job->output_bytes);
+
+            // Small faces only need a JPEG decoded at a fraction of its size
+            const QString extension = file_info.suffix().toLower();
+            if (size.isValid() && !options.unfolded && !options.preview && (extension == "jpg" || extension == "jpeg"))
+                job->edge = cubemapEdge(size.width(), options.edge_percent);
+
+            const BatchClock::time_point start = BatchClock::now();
+            job->image = loadInputImage(job->input_path, options.hdr, options.preview, 4 * job->edge);
+            decode_seconds += secondsSince(start);
+
+            if (job->image.isNull()) {
+                std::cerr << "Failed to load image: " << job->input_path.toStdString() << std::endl;
+                job->ok = false;
+            }
+            else if (options.unfolded && !checkUnfoldedCubemap(job->image.width(), job->image.height(), job->input_path)) {
+                job->ok = false;
+            }
+            else {
+                job->pixels = static_cast<qint64>(job->image.width()) * job->image.height();
+            }
+
+            decoded.push(std::move(job));
+        }
+
+        decoded.close();
+    });
+
+    // Stage 3: PNG save and DDS write
+    std::thread encoder([&] {
+
+        std::unique_ptr<BatchJob> job;
+        while (converted.pop(job)) {
+
+            if (job->ok) {
+                const BatchClock::time_point start = BatchClock::now();
+
+                const bool face_stack = !options.unfolded && !options.write_png;
+                const CubeProjection projection = options.convert.projection;
+                const CubemapMips* mips = options.mipmaps ? &job->mips : nullptr;
+
+                // The pool belongs to the convert stage, so the PNG strips are compressed on this thread
+                if (!options.unfolded && options.write_png && !writePNG(job->image, job->png_path, options.png_level)) {
+                    std::cerr << "Failed to save PNG: " << job->png_path.toStdString() << std::endl;
+                    job->ok = false;
+                }
+
+                bool written;
+                if (options.ktx2)
+                    written = writeKTX2(job->supercompressed, job->dds_path, projection);
+                else if (options.block_format != BlockFormat::None)
+                    written = writeCompressedCubemapToDDS(job->compressed, job->dds_path, projection);
+                else if (options.hdr) {
+                    FaceViews faces;
+                    if (face_stack)
+                        faces = faceStackViews(job->image);
+                    written = (face_stack || unfoldedFaceViews(job->image, faces)) &&
+                              writeHalfCubemapToDDS(faces, mips, job->dds_path, projection);
+                }
+                else if (face_stack)
+                    written = writeFaceStackToDDS(job->image, job->dds_path, mips, projection);
+                else
+                    written = writeCubemapToDDS(job->image, job->dds_path, mips, projection);
+                if (!written)
+                    job->ok = false;
+
+                encode_seconds += secondsSince(start);
+            }
+
+            if (job->ok) {
+                total_pixels += job->pixels;
+                std::cout << "[" << job->index + 1 << "/" << total << "] " << job->dds_path.toStdString() << std::endl;
+            }
+            else {
+                ++failed;
+            }
+
+            job->image = QImage();
+            job->mips = CubemapMips();
+            job->compressed = CompressedCubemap();
+            job->supercompressed = Ktx2Cubemap();
+            budget.release(job->output_bytes);
+        }
+    });
+
+    // Stage 2: convert on this thread, with the whole pool behind it
+    RemapTable remap;
+    std::unique_ptr<BatchJob> job;
+    while (decoded.pop(job)) {
+
+        if (job->ok && !options.unfolded) {
+
+            const BatchClock::time_point start = BatchClock::now();
+
+            const QImage& image_in = job->image;
+            const int edge = (job->edge > 0) ? job->edge : cubemapEdge(image_in.width(), options.edge_percent);
+
+            // Shoots are usually all the same size, so the remap table rarely changes
+            ConvertOptions convert = options.convert;
+            if (convert.filter == SampleFilter::Bilinear && !options.remap_cache_dir.isEmpty() &&
+                (remap.matches(image_in.width(), image_in.height(), edge, convert.projection) ||
+                 remap.loadOrBuild(options.remap_cache_dir, image_in.width(), image_in.height(), edge, pool, convert.projection)))
+                convert.remap = &remap;
+
+            // The PNG needs the unfolded cubemap, the DDS alone only needs the faces
+            const QImage::Format format = options.hdr ? QImage::Format_RGBA64 : QImage::Format_RGB32;
+            QImage image_out;
+            if (options.write_png) {
+                image_out = QImage(cubemapLayoutSize(options.layout, edge), format);
+                job->ok = convertEquirectToCubemap(image_in, image_out, pool, convert);
+            }
+            else {
+                image_out = QImage(edge, 6 * edge, format);
+                job->ok = convertEquirectToFaceStack(image_in, image_out, pool, convert);
+            }
+            job->image = image_out;
+
+            convert_seconds += secondsSince(start);
+        }
+
+        // Unfolded inputs are written as they are, once they have the faces' pixel format
+        if (job->ok && options.unfolded)
+            job->image = options.hdr ? makeSourceImage64(job->image) : makeSourceImage(job->image);
+
+        // Mips, block compression and supercompression are done here too, the pool can only be driven from this thread
+        if (job->ok && (options.mipmaps || options.block_format != BlockFormat::None || options.ktx2)) {
+
+            const BatchClock::time_point start = BatchClock::now();
+
+            const bool face_stack = !options.unfolded && !options.write_png;
+            FaceViews faces;
+            if (face_stack)
+                faces = faceStackViews(job->image);
+            else
+                job->ok = unfoldedFaceViews(job->image, faces);
+
+            if (job->ok && options.mipmaps)
+                buildCubemapMips(faces, pool, job->mips);
+
+            if (job->ok && options.block_format != BlockFormat::None) {
+                compressCubemap(faces, options.mipmaps ? &job->mips : nullptr, options.block_format, pool, job->compressed, options.block_quality);
+
+                // Only the PNG still needs the pixels
+                job->mips = CubemapMips();
+                if (!options.write_png || options.unfolded)
+                    job->image = QImage();
+            }
+
+            if (job->ok && options.ktx2) {
+                const bool encoded = (options.block_format != BlockFormat::None)
+                    ? encodeCompressedCubemapKTX2(job->compressed, pool, job->supercompressed, options.zstd_level)
+                    : encodeCubemapKTX2(faces, options.mipmaps ? &job->mips : nullptr, pool, job->supercompressed, options.zstd_level);
+                if (!encoded) {
+                    std::cerr << "Failed to supercompress the KTX2 levels for: " << job->dds_path.toStdString() << std::endl;
+                    job->ok = false;
+                }
+
+                // The KTX2 levels hold everything the file needs
+                job->compressed = CompressedCubemap();
+                job->mips = CubemapMips();
+                if (!options.write_png || options.unfolded)
+                    job->image = QImage();
+            }
+
+            convert_seconds += secondsSince(start);
+        }
+
+        // The decoded input is gone now
+        budget.release(job->input_bytes);
+        converted.push(std::move(job));
+    }
+
+    converted.close();
+    decoder.join();
+    encoder.join();
+
+    // Throughput summary
+    const double wall_seconds = secondsSince(batch_start);
+    const int converted_count = total - failed;
+
+    auto stageLine = [wall_seconds](const char* name, double seconds) {
+        std::printf("  %-8s %9.2f s busy (%3.0f%% of wall time)\n", name, seconds,
+                    wall_seconds > 0.0 ? 100.0 * seconds / wall_seconds : 0.0);
+    };
+
+    std::printf("Batch summary\n");
+    std::printf("  Images   %d of %d converted, %d failed\n", converted_count, total, failed);
+    std::printf("  Wall     %9.2f s, %.2f images/s, %.1f input Mpix/s\n", wall_seconds,
+                wall_seconds > 0.0 ? converted_count / wall_seconds : 0.0,
+                wall_seconds > 0.0 ? total_pixels / wall_seconds / 1.0e6 : 0.0);
+    stageLine("Decode", decode_seconds);
+    stageLine("Convert", convert_seconds);
+    stageLine("Encode", encode_seconds);
+    std::printf("  Memory   %.1f MB peak in flight", budget.peak() / (1024.0 * 1024.0));
+    if (options.memory_limit > 0)
+        std::printf(" (limit %.1f MB)", options.memory_limit / (1024.0 * 1024.0));
+    std::printf(", %.1f MB peak resident\n", peakResidentBytes() / (1024.0 * 1024.0));
+
+    return failed;
+}
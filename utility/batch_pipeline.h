@@ -0,0 +1,149 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef BATCH_PIPELINE_HPP
+#define BATCH_PIPELINE_HPP
+
+// C++ and STL includes
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Qt includes
+#include <QString>
+#include <QStringList>
+
+#include "cubemap_convert.h"
+#include "block_compress.h"
+#include "ktx2_writer.h"
+#include "png_writer.h"
+
+// How a batch of images is converted
+struct BatchOptions {
+    bool            unfolded = false;
+    bool            write_png = true;       // Without a PNG the faces are rendered straight into DDS order
+    int             png_level = PNG_ZLIB_LEVEL;
+    CubemapLayout   layout = CubemapLayout::Grid3x2;    // How the faces are arranged in the PNG
+    bool            mipmaps = true;         // Follow each face with its mip chain in the DDS
+    BlockFormat     block_format = BlockFormat::None;
+    BlockQuality    block_quality = BlockQuality::Normal;
+    bool            hdr = false;            // 16 bits per channel through to an RGBA16F (or BC6H) DDS
+    bool            ktx2 = false;           // Write Zstandard supercompressed KTX2 files rather than DDS
+    int             zstd_level = KTX2_ZSTD_LEVEL;
+    bool            preview = false;        // Quick conversions at most PREVIEW_WIDTH wide, named <name>_preview
+    int             edge_percent = 100;     // Face edge in percent of a quarter of the input width
+    ConvertOptions  convert;                // The remap table is managed by the batch itself
+    QString         remap_cache_dir;
+    qint64          memory_limit = 0;       // Bytes of in-flight image data, 0 for no limit
+};
+
+//
+// Fixed capacity queue handing work from one pipeline stage to the next
+//
+// push() blocks while the queue is full, pop() blocks while it is empty and
+// returns false once the queue has been closed and drained.
+//
+template<typename T>
+class BoundedQueue {
+
+public:
+
+    explicit BoundedQueue(size_t capacity) :
+        m_capacity(capacity) {
+    }
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this] { return m_items.size() < m_capacity; });
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this] { return !m_items.empty() || m_closed; });
+        if (m_items.empty())
+            return false;
+
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return true;
+    }
+
+    void close(void) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+    }
+
+private:
+
+    std::mutex              m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+    std::deque<T>           m_items;
+    size_t                  m_capacity;
+    bool                    m_closed = false;
+};
+
+//
+// Caps the bytes of image data the pipeline holds at once
+//
+// A job reserves its estimated size before it is decoded and gives it back as
+// its images are freed.  A job bigger than the whole limit is still let through
+// once nothing else is in flight, so an oversized image can't stall the batch.
+//
+class MemoryBudget {
+
+public:
+
+    explicit MemoryBudget(qint64 limit) :
+        m_limit(limit) {
+    }
+
+    void acquire(qint64 bytes);
+    void release(qint64 bytes);
+
+    inline qint64 peak(void) const {
+        return m_peak;
+    }
+
+private:
+
+    std::mutex              m_mutex;
+    std::condition_variable m_released;
+    qint64                  m_limit;
+    qint64                  m_in_use = 0;
+    qint64                  m_peak = 0;
+};
+
+// Expand directories and @list files into the list of images to convert
+QStringList collectBatchInputs(const QStringList& arguments, bool unfolded);
+
+// Convert every input with decode, convert and encode running as a pipeline,
+// returns the number of images that failed
+int runBatch(const QStringList& inputs, const BatchOptions& options, ThreadPool& pool);
+
+#endif // BATCH_PIPELINE_HPP
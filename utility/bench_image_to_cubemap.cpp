@@ -0,0 +1,472 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+// LibRaw includes
+#include <libraw/libraw.h>
+
+// Qt includes
+#include <QImage>
+#include <QImageReader>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QString>
+#include <QStringList>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "image_to_cubemap.h"
+#include "cubemap_convert.h"
+#include "cubemap_io.h"
+#include "mipmap.h"
+#include "png_writer.h"
+#include "fast_math.h"
+#include "thread_pool.h"
+#include "resource_usage.h"
+
+// The stages of a conversion, in the order image_to_cubemap runs them
+enum BenchStage { STAGE_LOAD, STAGE_CONVERT, STAGE_PNG, STAGE_MIPMAPS, STAGE_DDS, STAGE_COUNT };
+static const char* const STAGE_NAMES[STAGE_COUNT] = { "load", "convert", "png", "mipmaps", "dds" };
+
+// Timings of one stage over the measured runs, and the highest resident memory seen during it
+struct StageResult {
+    std::vector<double> milliseconds;
+    qint64              peak_bytes = 0;
+    double              megapixels = 0.0;   // Pixels the stage reads or writes, for the Mpix/s figure
+};
+
+// One image to benchmark, either a synthetic equirect written to the work directory or a user file
+struct BenchInput {
+    QString name;
+    QString path;
+    bool    synthetic;
+};
+
+//
+// Print the command line options
+//
+static void printUsage(void) {
+
+    std::cout << "Usage: ./bench_image_to_cubemap [options]\n"
+                 "Options:\n"
+                 "  --sizes WIDTHS            Comma separated synthetic equirect widths, such as 2k,4k or 6000\n"
+                 "                            (default 2k,4k,8k,16k)\n"
+                 "  --input PATH              Also time a real DNG/JPEG/PNG equirect, may be repeated\n"
+                 "  --runs N                  Measured runs per input (default 5)\n"
+                 "  --warmup N                Unmeasured runs before them (default 1)\n"
+                 "  -t, --threads N           Worker threads, 0 uses every core (default)\n"
+                 "  --simd KERNEL             auto, avx2, sse2 or scalar sampling kernel\n"
+                 "  --filter FILTER           bilinear (default) or area\n"
+                 "  --fast-math               Convert with the polynomial atan2 and hypot\n"
+                 "  --work-dir DIR            Where the inputs and outputs are written (default the temp dir)\n"
+                 "  --output FILE             Write the JSON report to FILE instead of stdout\n"
+              << std::endl;
+}
+
+// Parse a width such as 4096 or 4k, which is 4096, returning 0 when it isn't one
+static int parseWidth(QString text) {
+
+    text = text.trimmed().toLower();
+    int scale = 1;
+    if (text.endsWith('k')) {
+        scale = 1024;
+        text.chop(1);
+    }
+
+    bool ok = false;
+    const int width = text.toInt(&ok);
+    return (ok && width > 0) ? width * scale : 0;
+}
+
+// Value below which the fraction p of the sorted samples fall, by the nearest rank
+static double percentile(const std::vector<double>& sorted, double p) {
+
+    if (sorted.empty())
+        return 0.0;
+    const size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+// A 2:1 equirect with smooth colour bands, a grid and some noise, so the JPEG and
+// PNG encoders and the sampler see about as much detail as in a real panorama
+static QImage makeSyntheticEquirect(int width, ThreadPool& pool) {
+
+    const int height = std::max(1, width / 2);
+    QImage image(width, height, QImage::Format_RGB32);
+    const int grid = std::max(8, width / 64);
+
+    pool.parallelFor(height, [&](int y) {
+
+        QRgb* row = reinterpret_cast<QRgb*>(image.scanLine(y));
+        const float lat = static_cast<float>(M_PI) * (y + 0.5f) / height;
+
+        for (int x = 0; x < width; ++x) {
+
+            const float lon = 2.0f * static_cast<float>(M_PI) * (x + 0.5f) / width;
+
+            // A cheap hash of the position as noise of +-8 levels
+            const quint32 hash = (static_cast<quint32>(x) * 73856093u ^ static_cast<quint32>(y) * 19349663u) * 2654435761u;
+            const int noise = static_cast<int>(hash >> 28) - 8;
+            const int line = (x % grid == 0 || y % grid == 0) ? 64 : 0;
+
+            const int r = 128 + static_cast<int>(96.0f * std::sin(3.0f * lon) * std::sin(lat)) + noise + line;
+            const int g = 128 + static_cast<int>(96.0f * std::cos(2.0f * lat)) + noise + line;
+            const int b = 128 + static_cast<int>(96.0f * std::cos(lon + lat)) - noise + line;
+            row[x] = qRgb(clip(r, 0, 255), clip(g, 0, 255), clip(b, 0, 255));
+        }
+    });
+
+    return image;
+}
+
+// Run every stage of one conversion of path, adding the timings to results when measured
+static bool runConversion(const QString& path, const QString& output_base, ThreadPool& pool,
+                          const ConvertOptions& options, bool measured, StageResult* results) {
+
+    QElapsedTimer timer;
+    auto finishStage = [&](BenchStage stage) {
+        if (measured) {
+            results[stage].milliseconds.push_back(timer.nsecsElapsed() / 1.0e6);
+            results[stage].peak_bytes = std::max(results[stage].peak_bytes, peakResidentBytes());
+        }
+        resetPeakResidentBytes();
+        timer.start();
+    };
+
+    resetPeakResidentBytes();
+    timer.start();
+
+    QImage image_in = loadInputImage(path);
+    if (image_in.isNull()) {
+        std::cerr << "Failed to load image: " << path.toStdString() << std::endl;
+        return false;
+    }
+    finishStage(STAGE_LOAD);
+
+    const int edge = cubemapEdge(image_in.width());
+    QImage image_unfolded(cubemapLayoutSize(CubemapLayout::Grid3x2, edge), QImage::Format_RGB32);
+    if (!convertEquirectToCubemap(image_in, image_unfolded, pool, options))
+        return false;
+    finishStage(STAGE_CONVERT);
+    image_in = QImage();
+
+    if (!writePNG(image_unfolded, output_base + ".png", PNG_ZLIB_LEVEL, &pool)) {
+        std::cerr << "Failed to save the PNG to " << output_base.toStdString() << ".png" << std::endl;
+        return false;
+    }
+    finishStage(STAGE_PNG);
+
+    FaceViews faces;
+    if (!unfoldedFaceViews(image_unfolded, faces))
+        return false;
+    CubemapMips mips;
+    buildCubemapMips(faces, pool, mips);
+    finishStage(STAGE_MIPMAPS);
+
+    if (!writeCubemapToDDS(image_unfolded, output_base + ".dds", &mips, CubeProjection::Standard, CUBEMAP_ALL_FACES, &pool)) {
+        std::cerr << "Failed to write the DDS to " << output_base.toStdString() << ".dds" << std::endl;
+        return false;
+    }
+    finishStage(STAGE_DDS);
+
+    return true;
+}
+
+// 
+// Application begins
+// 
+int main(int argc, char** argv) {
+
+    std::vector<int> sizes;
+    bool sizes_given = false;
+    QStringList input_paths;
+    int runs = 5;
+    int warmup = 1;
+    int threads = 0;
+    ConvertOptions options;
+    QString work_dir = QDir::tempPath();
+    QString output_path;
+
+    for (int argIndex = 1; argIndex < argc; ++argIndex) {
+
+        const std::string arg(argv[argIndex]);
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        }
+        else if (arg == "--sizes") {
+            const QStringList widths = (++argIndex < argc) ? QString::fromStdString(argv[argIndex]).split(',') : QStringList();
+            for (const QString& width : widths) {
+                sizes.push_back(parseWidth(width));
+                if (sizes.back() < 4) {
+                    std::cerr << "Error: --sizes needs comma separated widths, such as 2k,4k,6000\n";
+                    return 1;
+                }
+            }
+            if (sizes.empty()) {
+                std::cerr << "Error: --sizes needs comma separated widths, such as 2k,4k,6000\n";
+                return 1;
+            }
+            sizes_given = true;
+        }
+        else if (arg == "--input") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs an image path\n";
+                return 1;
+            }
+            input_paths.push_back(QString::fromStdString(argv[argIndex]));
+        }
+        else if (arg == "--runs") {
+            if (++argIndex >= argc || atoi(argv[argIndex]) < 1) {
+                std::cerr << "Error: " << arg << " needs a run count of at least 1\n";
+                return 1;
+            }
+            runs = atoi(argv[argIndex]);
+        }
+        else if (arg == "--warmup") {
+            if (++argIndex >= argc || atoi(argv[argIndex]) < 0) {
+                std::cerr << "Error: " << arg << " needs a run count\n";
+                return 1;
+            }
+            warmup = atoi(argv[argIndex]);
+        }
+        else if (arg == "-t" || arg == "--threads") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs a thread count\n";
+                return 1;
+            }
+            threads = atoi(argv[argIndex]);
+        }
+        else if (arg == "--simd") {
+            const std::string name = (++argIndex < argc) ? argv[argIndex] : "";
+            if (name == "auto")
+                options.kernel = SampleKernel::Auto;
+            else if (name == "avx2")
+                options.kernel = SampleKernel::AVX2;
+            else if (name == "sse2")
+                options.kernel = SampleKernel::SSE2;
+            else if (name == "scalar")
+                options.kernel = SampleKernel::Scalar;
+            else {
+                std::cerr << "Error: --simd must be one of auto, avx2, sse2 or scalar\n";
+                return 1;
+            }
+        }
+        else if (arg == "--filter") {
+            const std::string name = (++argIndex < argc) ? argv[argIndex] : "";
+            if (name == "bilinear")
+                options.filter = SampleFilter::Bilinear;
+            else if (name == "area")
+                options.filter = SampleFilter::Area;
+            else {
+                std::cerr << "Error: --filter must be one of bilinear or area\n";
+                return 1;
+            }
+        }
+        else if (arg == "--fast-math") {
+            options.fast_math = true;
+        }
+        else if (arg == "--work-dir") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs a directory\n";
+                return 1;
+            }
+            work_dir = QString::fromStdString(argv[argIndex]);
+        }
+        else if (arg == "--output") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs a file path\n";
+                return 1;
+            }
+            output_path = QString::fromStdString(argv[argIndex]);
+        }
+        else {
+            std::cerr << "Error: unknown option " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    // Real inputs on their own only time those, otherwise the synthetic ladder runs too
+    if (!sizes_given && input_paths.empty())
+        sizes = { 2048, 4096, 8192, 16384 };
+
+    // Make sure Qt will deal with large images
+    QImageReader::setAllocationLimit(4000);
+
+    // The converter's progress goes to stdout, send it to stderr with ours so stdout only holds the JSON
+    std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    ThreadPool pool(threads);
+    const QString work_base = QDir(work_dir).filePath("bench_image_to_cubemap");
+
+    // Synthetic inputs are written as JPEGs, the format most panoramas arrive in
+    std::vector<BenchInput> inputs;
+    for (int width : sizes) {
+
+        const QString name = QString("synthetic_%1x%2").arg(width).arg(std::max(1, width / 2));
+        const QString path = work_base + "_" + name + ".jpg";
+
+        std::cerr << "Generating " << name.toStdString() << std::endl;
+        if (!makeSyntheticEquirect(width, pool).save(path, "JPG", 90)) {
+            std::cerr << "Failed to write the synthetic input " << path.toStdString() << std::endl;
+            std::cout.rdbuf(stdout_buffer);
+            return 1;
+        }
+        inputs.push_back({ name, path, true });
+    }
+    for (const QString& path : input_paths)
+        inputs.push_back({ QFileInfo(path).fileName(), path, false });
+
+    QJsonArray input_reports;
+    bool ok = true;
+
+    for (const BenchInput& input : inputs) {
+
+        const QSize size = probeImageSize(input.path);
+        if (!size.isValid()) {
+            std::cerr << "Failed to read the size of " << input.path.toStdString() << std::endl;
+            ok = false;
+            break;
+        }
+
+        // Megapixels each stage handles: the decoded input, the six faces, and the 3x2 PNG canvas
+        const int edge = cubemapEdge(size.width());
+        const double input_mpix = static_cast<double>(size.width()) * size.height() / 1.0e6;
+        const double face_mpix = 6.0 * edge * edge / 1.0e6;
+        const QSize png_size = cubemapLayoutSize(CubemapLayout::Grid3x2, edge);
+        const double png_mpix = static_cast<double>(png_size.width()) * png_size.height() / 1.0e6;
+
+        StageResult results[STAGE_COUNT];
+        results[STAGE_LOAD].megapixels = input_mpix;
+        results[STAGE_CONVERT].megapixels = face_mpix;
+        results[STAGE_PNG].megapixels = png_mpix;
+        results[STAGE_MIPMAPS].megapixels = face_mpix;
+        results[STAGE_DDS].megapixels = face_mpix;
+
+        for (int run = 0; run < warmup + runs; ++run) {
+            std::cerr << input.name.toStdString() << ": run " << run + 1 << " of " << warmup + runs
+                      << (run < warmup ? " (warmup)" : "") << std::endl;
+            if (!runConversion(input.path, work_base + "_out", pool, options, run >= warmup, results)) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok)
+            break;
+
+        QJsonObject stages;
+        double total_ms = 0.0;
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+
+            std::vector<double> sorted = results[stage].milliseconds;
+            std::sort(sorted.begin(), sorted.end());
+            const double median = percentile(sorted, 0.5);
+            total_ms += median;
+
+            QJsonObject report;
+            report["megapixels"] = results[stage].megapixels;
+            report["min_ms"] = sorted.front();
+            report["median_ms"] = median;
+            report["p95_ms"] = percentile(sorted, 0.95);
+            report["mpix_per_s"] = median > 0.0 ? results[stage].megapixels * 1000.0 / median : 0.0;
+            report["peak_rss_mb"] = static_cast<double>(results[stage].peak_bytes) / (1024 * 1024);
+            stages[STAGE_NAMES[stage]] = report;
+        }
+
+        QJsonObject input_report;
+        input_report["name"] = input.name;
+        input_report["synthetic"] = input.synthetic;
+        input_report["width"] = size.width();
+        input_report["height"] = size.height();
+        input_report["edge"] = edge;
+        input_report["input_bytes"] = QFileInfo(input.path).size();
+        input_report["total_median_ms"] = total_ms;
+        input_report["input_mpix_per_s"] = total_ms > 0.0 ? input_mpix * 1000.0 / total_ms : 0.0;
+        input_report["stages"] = stages;
+
+        // The fast math error is reported whether or not the conversions used it
+        const FastMathError error = measureFastMath(size.width(), size.height(), edge, options.kernel);
+        QJsonObject fast_math;
+        fast_math["max_u_px"] = error.max_u;
+        fast_math["max_v_px"] = error.max_v;
+        fast_math["points"] = error.points;
+        fast_math["differing_points"] = error.differing_points;
+        fast_math["kernel_mismatches"] = error.kernel_mismatches;
+        fast_math["bound_u_px"] = fastMathErrorBound(size.width());
+        fast_math["bound_v_px"] = fastMathErrorBound(size.height());
+        fast_math["within_bound"] = fastMathWithinBound(error, size.width(), size.height());
+        input_report["fast_math_error"] = fast_math;
+        input_reports.append(input_report);
+    }
+
+    // Leave nothing behind in the work directory
+    for (const BenchInput& input : inputs)
+        if (input.synthetic)
+            QFile::remove(input.path);
+    QFile::remove(work_base + "_out.png");
+    QFile::remove(work_base + "_out.dds");
+
+    std::cout.rdbuf(stdout_buffer);
+    if (!ok)
+        return 1;
+
+    // The versions that were measured, so runs before and after an upgrade can be told apart
+    QJsonObject report;
+    report["benchmark"] = "image_to_cubemap";
+    report["qt_version"] = qVersion();
+    report["libraw_version"] = LibRaw::version();
+    report["threads"] = pool.threadCount();
+    report["kernel"] = sampleKernelName(resolveSampleKernel(options.kernel));
+    report["filter"] = options.filter == SampleFilter::Area ? "area" : "bilinear";
+    report["fast_math"] = options.fast_math;
+    report["runs"] = runs;
+    report["warmup"] = warmup;
+    report["inputs"] = input_reports;
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (output_path.isEmpty()) {
+        std::cout << json.constData() << std::endl;
+    }
+    else {
+        QFile file(output_path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            std::cerr << "Failed to write the report to " << output_path.toStdString() << std::endl;
+            return 1;
+        }
+        std::cerr << "Wrote the report to " << output_path.toStdString() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,814 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "image_to_cubemap.h"
+#include "block_compress.h"
+#include "half_float.h"
+
+int blockBytes(BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+qsizetype compressedLevelBytes(int width, int height, BlockFormat format) {
+
+    const qsizetype blocks_x = std::max(1, (width + 3) / 4);
+    const qsizetype blocks_y = std::max(1, (height + 3) / 4);
+    return blocks_x * blocks_y * blockBytes(format);
+}
+
+const char* blockFormatName(BlockFormat format) {
+
+    switch (format) {
+    case BlockFormat::BC1:  return "bc1";
+    case BlockFormat::BC3:  return "bc3";
+    case BlockFormat::BC7:  return "bc7";
+    case BlockFormat::BC6H: return "bc6h";
+    default:                return "rgba";
+    }
+}
+
+//
+// Fit a line through the pixels of a block
+//
+// The mean and the principal axis (power iteration on the covariance) of the
+// first channels of each value, the axis is left unnormalised when the block
+// is a single flat colour.
+//
+static void fitLine(const float values[16][4], int channels, float mean[4], float axis[4]) {
+
+    for (int c = 0; c < channels; ++c) {
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; ++i)
+            mean[c] += values[i][c];
+        mean[c] /= 16.0f;
+    }
+
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < channels; ++b)
+                cov[a][b] += (values[i][a] - mean[a]) * (values[i][b] - mean[b]);
+
+    // Start from the row of the channel that varies the most
+    int widest = 0;
+    for (int c = 1; c < channels; ++c)
+        if (cov[c][c] > cov[widest][widest])
+            widest = c;
+    for (int c = 0; c < channels; ++c)
+        axis[c] = cov[widest][c];
+
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b)
+                next[a] += cov[a][b] * axis[b];
+            length += next[a] * next[a];
+        }
+        if (length < 1e-12f)
+            break;
+
+        length = std::sqrt(length);
+        for (int c = 0; c < channels; ++c)
+            axis[c] = next[c] / length;
+    }
+}
+
+// Find the two ends of the pixels' spread along the fitted line, clipped to 0 .. limit
+static void lineEndpoints(const float values[16][4], int channels, const float mean[4], const float axis[4], float low[4], float high[4], float limit = 255.0f) {
+
+    float t_min = std::numeric_limits<float>::max();
+    float t_max = -std::numeric_limits<float>::max();
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; ++c)
+            t += (values[i][c] - mean[c]) * axis[c];
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+
+    for (int c = 0; c < channels; ++c) {
+        low[c] = clip(mean[c] + t_min * axis[c], 0.0f, limit);
+        high[c] = clip(mean[c] + t_max * axis[c], 0.0f, limit);
+    }
+}
+
+/***********************************************************************/
+
+static int packRGB565(const float rgb[3]) {
+
+    const int r = clip(static_cast<int>(rgb[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    const int g = clip(static_cast<int>(rgb[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    const int b = clip(static_cast<int>(rgb[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (r << 11) | (g << 5) | b;
+}
+
+static void unpackRGB565(int color, int rgb[3]) {
+
+    const int r = (color >> 11) & 31;
+    const int g = (color >> 5) & 63;
+    const int b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+//
+// Pick the nearest of the four palette colours for every pixel
+//
+// Expects c0 > c1 (four colour mode), or c0 == c1 in which case every pixel
+// gets index 0 since index 3 would decode as black.  Returns the squared error.
+//
+static int colorIndices(const float values[16][4], int c0, int c1, quint32& indices) {
+
+    int palette[4][3];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    const int candidates = (c0 == c1) ? 1 : 4;
+
+    indices = 0;
+    int total = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        int best_error = std::numeric_limits<int>::max();
+        for (int k = 0; k < candidates; ++k) {
+            int error = 0;
+            for (int c = 0; c < 3; ++c) {
+                const int d = static_cast<int>(values[i][c]) - palette[k][c];
+                error += d * d;
+            }
+            if (error < best_error) {
+                best_error = error;
+                best = k;
+            }
+        }
+        indices |= static_cast<quint32>(best) << (2 * i);
+        total += best_error;
+    }
+
+    return total;
+}
+
+// Quantise both endpoints, order them for four colour mode and find the indices
+static int encodeColorEndpoints(const float values[16][4], const float e0[3], const float e1[3], int& c0, int& c1, quint32& indices) {
+
+    c0 = packRGB565(e0);
+    c1 = packRGB565(e1);
+    if (c0 < c1)
+        std::swap(c0, c1);
+    return colorIndices(values, c0, c1, indices);
+}
+
+//
+// Encode the 8-byte BC1 colour block shared by BC1 and BC3
+//
+// Endpoints start at the ends of the principal axis, then get one least squares
+// refit against the indices they produced, whichever has the lower error wins.
+//
+static void compressColorBlock(const uchar* pixels, uchar* out) {
+
+    // Pixels are B, G, R, A in memory
+    float values[16][4];
+    for (int i = 0; i < 16; ++i) {
+        values[i][0] = pixels[i * 4 + 2];
+        values[i][1] = pixels[i * 4 + 1];
+        values[i][2] = pixels[i * 4 + 0];
+        values[i][3] = 0.0f;
+    }
+
+    float mean[4], axis[4], low[4], high[4];
+    fitLine(values, 3, mean, axis);
+    lineEndpoints(values, 3, mean, axis, low, high);
+
+    int c0, c1;
+    quint32 indices;
+    int error = encodeColorEndpoints(values, high, low, c0, c1, indices);
+
+    // Least squares refit, index k puts weight w on c0 and 1 - w on c1
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    if (error > 0 && c0 != c1) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[3] = {}, bx[3] = {};
+        for (int i = 0; i < 16; ++i) {
+            const float w = weights[(indices >> (2 * i)) & 3];
+            aa += w * w;
+            ab += w * (1.0f - w);
+            bb += (1.0f - w) * (1.0f - w);
+            for (int c = 0; c < 3; ++c) {
+                ax[c] += w * values[i][c];
+                bx[c] += (1.0f - w) * values[i][c];
+            }
+        }
+
+        const float det = aa * bb - ab * ab;
+        if (std::fabs(det) > 1e-6f) {
+            float e0[3], e1[3];
+            for (int c = 0; c < 3; ++c) {
+                e0[c] = clip((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+                e1[c] = clip((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+            }
+
+            int r0, r1;
+            quint32 refit_indices;
+            if (encodeColorEndpoints(values, e0, e1, r0, r1, refit_indices) < error) {
+                c0 = r0;
+                c1 = r1;
+                indices = refit_indices;
+            }
+        }
+    }
+
+    out[0] = static_cast<uchar>(c0);
+    out[1] = static_cast<uchar>(c0 >> 8);
+    out[2] = static_cast<uchar>(c1);
+    out[3] = static_cast<uchar>(c1 >> 8);
+    for (int b = 0; b < 4; ++b)
+        out[4 + b] = static_cast<uchar>(indices >> (8 * b));
+}
+
+// Encode the 8-byte BC3 alpha block, always in eight alpha mode
+static void compressAlphaBlock(const uchar* pixels, uchar* out) {
+
+    int alpha_min = 255, alpha_max = 0;
+    for (int i = 0; i < 16; ++i) {
+        alpha_min = std::min(alpha_min, static_cast<int>(pixels[i * 4 + 3]));
+        alpha_max = std::max(alpha_max, static_cast<int>(pixels[i * 4 + 3]));
+    }
+
+    out[0] = static_cast<uchar>(alpha_max);
+    out[1] = static_cast<uchar>(alpha_min);
+
+    // A flat alpha is all index 0
+    quint64 bits = 0;
+    if (alpha_max > alpha_min) {
+        int palette[8];
+        palette[0] = alpha_max;
+        palette[1] = alpha_min;
+        for (int k = 1; k < 7; ++k)
+            palette[k + 1] = ((7 - k) * alpha_max + k * alpha_min) / 7;
+
+        for (int i = 0; i < 16; ++i) {
+            const int alpha = pixels[i * 4 + 3];
+            int best = 0;
+            for (int k = 1; k < 8; ++k)
+                if (std::abs(palette[k] - alpha) < std::abs(palette[best] - alpha))
+                    best = k;
+            bits |= static_cast<quint64>(best) << (3 * i);
+        }
+    }
+
+    for (int b = 0; b < 6; ++b)
+        out[2 + b] = static_cast<uchar>(bits >> (8 * b));
+}
+
+void compressBlockBC1(const uchar* pixels, uchar* out) {
+    compressColorBlock(pixels, out);
+}
+
+void compressBlockBC3(const uchar* pixels, uchar* out) {
+    compressAlphaBlock(pixels, out);
+    compressColorBlock(pixels, out + 8);
+}
+
+/***********************************************************************/
+
+// Writes a BC7 block least significant bit first
+struct BlockBits {
+
+    quint64 lo = 0;
+    quint64 hi = 0;
+    int     pos = 0;
+
+    void put(quint32 value, int count) {
+        for (int b = 0; b < count; ++b, ++pos) {
+            const quint64 bit = (value >> b) & 1;
+            if (pos < 64)
+                lo |= bit << pos;
+            else
+                hi |= bit << (pos - 64);
+        }
+    }
+
+    void store(uchar* out) const {
+        for (int b = 0; b < 8; ++b) {
+            out[b] = static_cast<uchar>(lo >> (8 * b));
+            out[8 + b] = static_cast<uchar>(hi >> (8 * b));
+        }
+    }
+};
+
+// BC7 4-bit index interpolation weights, out of 64
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+//
+// Find the best 4-bit index of every pixel between two 8-bit RGBA endpoints
+//
+// The projection onto the endpoint line gives a first guess, its neighbours are
+// checked too since the BC7 weights aren't evenly spaced.  Returns the squared error.
+//
+static int bc7Indices(const float values[16][4], const int v0[4], const int v1[4], int indices[16]) {
+
+    float dir[4];
+    float length = 0.0f;
+    for (int c = 0; c < 4; ++c) {
+        dir[c] = static_cast<float>(v1[c] - v0[c]);
+        length += dir[c] * dir[c];
+    }
+    const float scale = (length > 0.0f) ? 15.0f / length : 0.0f;
+
+    int total = 0;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < 4; ++c)
+            t += (values[i][c] - v0[c]) * dir[c];
+        const int guess = clip(static_cast<int>(t * scale + 0.5f), 0, 15);
+
+        int best = guess;
+        int best_error = std::numeric_limits<int>::max();
+        for (int k = std::max(0, guess - 1); k <= std::min(15, guess + 1); ++k) {
+            const int w = BC7_WEIGHTS4[k];
+            int error = 0;
+            for (int c = 0; c < 4; ++c) {
+                const int decoded = ((64 - w) * v0[c] + w * v1[c] + 32) >> 6;
+                const int d = static_cast<int>(values[i][c]) - decoded;
+                error += d * d;
+            }
+            if (error < best_error) {
+                best_error = error;
+                best = k;
+            }
+        }
+
+        indices[i] = best;
+        total += best_error;
+    }
+
+    return total;
+}
+
+//
+// Encode a BC7 block in mode 6
+//
+// Mode 6 has one subset with 7.7.7.7 RGBA endpoints, a p-bit each and 4-bit
+// indices, which suits smooth photographic content.  All four p-bit choices
+// are tried on the principal axis endpoints and the one with least error kept.
+//
+void compressBlockBC7(const uchar* pixels, uchar* out) {
+
+    // Pixels are B, G, R, A in memory
+    float values[16][4];
+    for (int i = 0; i < 16; ++i) {
+        values[i][0] = pixels[i * 4 + 2];
+        values[i][1] = pixels[i * 4 + 1];
+        values[i][2] = pixels[i * 4 + 0];
+        values[i][3] = pixels[i * 4 + 3];
+    }
+
+    float mean[4], axis[4], low[4], high[4];
+    fitLine(values, 4, mean, axis);
+    lineEndpoints(values, 4, mean, axis, low, high);
+
+    int best_error = std::numeric_limits<int>::max();
+    int best_q0[4] = {}, best_q1[4] = {}, best_p0 = 0, best_p1 = 0;
+    int best_indices[16] = {};
+
+    for (int p0 = 0; p0 < 2; ++p0) {
+        for (int p1 = 0; p1 < 2; ++p1) {
+
+            int q0[4], q1[4], v0[4], v1[4];
+            for (int c = 0; c < 4; ++c) {
+                q0[c] = clip(static_cast<int>((low[c] - p0) / 2.0f + 0.5f), 0, 127);
+                q1[c] = clip(static_cast<int>((high[c] - p1) / 2.0f + 0.5f), 0, 127);
+                v0[c] = (q0[c] << 1) | p0;
+                v1[c] = (q1[c] << 1) | p1;
+            }
+
+            int indices[16];
+            const int error = bc7Indices(values, v0, v1, indices);
+            if (error < best_error) {
+                best_error = error;
+                std::copy(q0, q0 + 4, best_q0);
+                std::copy(q1, q1 + 4, best_q1);
+                std::copy(indices, indices + 16, best_indices);
+                best_p0 = p0;
+                best_p1 = p1;
+            }
+        }
+    }
+
+    // The first index is stored without its top bit, so it must be below 8
+    if (best_indices[0] & 8) {
+        std::swap(best_q0, best_q1);
+        std::swap(best_p0, best_p1);
+        for (int i = 0; i < 16; ++i)
+            best_indices[i] = 15 - best_indices[i];
+    }
+
+    BlockBits bits;
+    bits.put(1 << 6, 7);                // Mode 6
+    for (int c = 0; c < 4; ++c) {       // R0 R1 G0 G1 B0 B1 A0 A1
+        bits.put(best_q0[c], 7);
+        bits.put(best_q1[c], 7);
+    }
+    bits.put(best_p0, 1);
+    bits.put(best_p1, 1);
+    bits.put(best_indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+        bits.put(best_indices[i], 4);
+
+    bits.store(out);
+}
+
+/***********************************************************************/
+
+//
+// BC6H unsigned half float
+//
+// The decoder unquantises endpoints to 16 bits, interpolates them with the BC7
+// weights and scales the result by 31/64 into half float bits, so endpoints are
+// fitted in that 16-bit space.  Errors are measured on the half bits, which
+// weighs them by relative rather than absolute brightness.  Only the one region
+// modes are used, they suit smooth HDR skies and have the most index precision.
+//
+
+// A one region BC6H mode
+struct BC6HMode {
+    quint32 bits;           // The 5 mode bits
+    int     precision;      // Bits of the first endpoint
+    int     delta;          // Bits of the second endpoint as a signed difference, 0 when stored whole
+};
+
+static const BC6HMode BC6H_MODES[4] = {
+    { 0x03, 10, 0 },        // Mode 11, two 10-bit endpoints
+    { 0x07, 11, 9 },        // Mode 12
+    { 0x0B, 12, 8 },        // Mode 13
+    { 0x0F, 16, 4 }         // Mode 14, for almost flat blocks
+};
+
+static int bc6hUnquantize(int value, int precision) {
+
+    if (precision >= 15)
+        return value;
+    if (value == 0)
+        return 0;
+    if (value == (1 << precision) - 1)
+        return 0xFFFF;
+    return ((value << 16) + 0x8000) >> precision;
+}
+
+// The quantised value that unquantises closest to a 16-bit endpoint
+static int bc6hQuantize(float value, int precision) {
+
+    const int top = (1 << precision) - 1;
+    const int guess = clip(static_cast<int>(value * (1 << precision) / 65536.0f), 0, top);
+
+    int best = guess;
+    float best_error = std::numeric_limits<float>::max();
+    for (int q = std::max(0, guess - 1); q <= std::min(top, guess + 1); ++q) {
+        const float error = std::fabs(bc6hUnquantize(q, precision) - value);
+        if (error < best_error) {
+            best_error = error;
+            best = q;
+        }
+    }
+    return best;
+}
+
+// Quantise a pair of endpoints for a mode, keeping the second within reach of the first
+static void bc6hQuantizeEndpoints(const BC6HMode& mode, const float e0[3], const float e1[3], int q0[3], int q1[3]) {
+
+    for (int c = 0; c < 3; ++c) {
+        q0[c] = bc6hQuantize(e0[c], mode.precision);
+        q1[c] = bc6hQuantize(e1[c], mode.precision);
+
+        // The range is kept symmetric so the endpoints can still be swapped for the anchor index
+        if (mode.delta) {
+            const int reach = (1 << (mode.delta - 1)) - 1;
+            q1[c] = clip(q1[c], q0[c] - reach, q0[c] + reach);
+        }
+    }
+}
+
+// Pick the nearest palette entry for every pixel, returns the squared error in half bits
+static qint64 bc6hIndices(const int halfs[16][3], const BC6HMode& mode, const int q0[3], const int q1[3], int indices[16]) {
+
+    int palette[16][3];
+    for (int c = 0; c < 3; ++c) {
+        const int a = bc6hUnquantize(q0[c], mode.precision);
+        const int b = bc6hUnquantize(q1[c], mode.precision);
+        for (int k = 0; k < 16; ++k) {
+            const int w = BC7_WEIGHTS4[k];
+            palette[k][c] = ((((64 - w) * a + w * b + 32) >> 6) * 31) >> 6;
+        }
+    }
+
+    qint64 total = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        qint64 best_error = std::numeric_limits<qint64>::max();
+        for (int k = 0; k < 16; ++k) {
+            qint64 error = 0;
+            for (int c = 0; c < 3; ++c) {
+                const qint64 d = halfs[i][c] - palette[k][c];
+                error += d * d;
+            }
+            if (error < best_error) {
+                best_error = error;
+                best = k;
+            }
+        }
+        indices[i] = best;
+        total += best_error;
+    }
+
+    return total;
+}
+
+// Least squares endpoints for the indices, index k puts weight w on e1 and 1 - w on e0
+static bool bc6hRefit(const float values[16][4], const int indices[16], float e0[3], float e1[3]) {
+
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; ++i) {
+        const float w = BC7_WEIGHTS4[indices[i]] / 64.0f;
+        aa += (1.0f - w) * (1.0f - w);
+        ab += w * (1.0f - w);
+        bb += w * w;
+        for (int c = 0; c < 3; ++c) {
+            ax[c] += (1.0f - w) * values[i][c];
+            bx[c] += w * values[i][c];
+        }
+    }
+
+    const float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+
+    for (int c = 0; c < 3; ++c) {
+        e0[c] = clip((ax[c] * bb - bx[c] * ab) / det, 0.0f, 65535.0f);
+        e1[c] = clip((bx[c] * aa - ax[c] * ab) / det, 0.0f, 65535.0f);
+    }
+    return true;
+}
+
+// Writes the bits of value from bit first down to bit last, for the fields BC6H stores reversed
+static void putReversed(BlockBits& bits, int value, int first, int last) {
+    for (int b = first; b >= last; --b)
+        bits.put((value >> b) & 1, 1);
+}
+
+//
+// Compress one 4x4 block of R, G, B, A halfs (16 pixels, row by row)
+//
+// Every mode starts from the principal axis endpoints.  Normal quality adds a
+// least squares refit, slow quality then nudges each quantised endpoint by one
+// step for as long as that lowers the error.
+//
+void compressBlockBC6H(const quint16* pixels, uchar* out, BlockQuality quality) {
+
+    // Negative halfs can't be stored and the largest finite half is 0x7BFF
+    int halfs[16][3];
+    float values[16][4];
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const int half = pixels[i * 4 + c];
+            halfs[i][c] = (half & 0x8000) ? 0 : std::min(half, 0x7BFF);
+            values[i][c] = std::min(halfs[i][c] * 64.0f / 31.0f, 65535.0f);
+        }
+        values[i][3] = 0.0f;
+    }
+
+    float mean[4], axis[4], low[4], high[4];
+    fitLine(values, 3, mean, axis);
+    lineEndpoints(values, 3, mean, axis, low, high, 65535.0f);
+
+    const int mode_count = (quality == BlockQuality::Fast) ? 1 : 4;
+
+    qint64 best_error = std::numeric_limits<qint64>::max();
+    int best_mode = 0;
+    int best_q0[3] = {}, best_q1[3] = {};
+    int best_indices[16] = {};
+
+    for (int m = 0; m < mode_count && best_error > 0; ++m) {
+        const BC6HMode& mode = BC6H_MODES[m];
+
+        int q0[3], q1[3], indices[16];
+        bc6hQuantizeEndpoints(mode, low, high, q0, q1);
+        qint64 error = bc6hIndices(halfs, mode, q0, q1, indices);
+
+        float e0[3], e1[3];
+        if (quality != BlockQuality::Fast && error > 0 && bc6hRefit(values, indices, e0, e1)) {
+            int r0[3], r1[3], refit_indices[16];
+            bc6hQuantizeEndpoints(mode, e0, e1, r0, r1);
+            const qint64 refit_error = bc6hIndices(halfs, mode, r0, r1, refit_indices);
+            if (refit_error < error) {
+                error = refit_error;
+                std::copy(r0, r0 + 3, q0);
+                std::copy(r1, r1 + 3, q1);
+                std::copy(refit_indices, refit_indices + 16, indices);
+            }
+        }
+
+        if (quality == BlockQuality::Slow) {
+            const int top = (1 << mode.precision) - 1;
+            const int reach = mode.delta ? (1 << (mode.delta - 1)) - 1 : top;
+            bool improved = true;
+            while (improved && error > 0) {
+                improved = false;
+                for (int e = 0; e < 6; ++e) {
+                    for (int step = -1; step <= 1; step += 2) {
+                        int t0[3], t1[3], trial_indices[16];
+                        std::copy(q0, q0 + 3, t0);
+                        std::copy(q1, q1 + 3, t1);
+                        int& value = (e < 3) ? t0[e] : t1[e - 3];
+                        value += step;
+                        if (value < 0 || value > top || std::abs(t1[e % 3] - t0[e % 3]) > reach)
+                            continue;
+
+                        const qint64 trial_error = bc6hIndices(halfs, mode, t0, t1, trial_indices);
+                        if (trial_error < error) {
+                            error = trial_error;
+                            std::copy(t0, t0 + 3, q0);
+                            std::copy(t1, t1 + 3, q1);
+                            std::copy(trial_indices, trial_indices + 16, indices);
+                            improved = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (error < best_error) {
+            best_error = error;
+            best_mode = m;
+            std::copy(q0, q0 + 3, best_q0);
+            std::copy(q1, q1 + 3, best_q1);
+            std::copy(indices, indices + 16, best_indices);
+        }
+    }
+
+    // The first index is stored without its top bit, the palette is symmetric so swapping costs nothing
+    if (best_indices[0] & 8) {
+        std::swap(best_q0, best_q1);
+        for (int i = 0; i < 16; ++i)
+            best_indices[i] = 15 - best_indices[i];
+    }
+
+    const BC6HMode& mode = BC6H_MODES[best_mode];
+
+    BlockBits bits;
+    bits.put(mode.bits, 5);
+    for (int c = 0; c < 3; ++c)         // rw gw bw, the low 10 bits of the first endpoint
+        bits.put(best_q0[c] & 0x3FF, 10);
+
+    for (int c = 0; c < 3; ++c) {       // rx gx bx, each followed by the top bits of the first endpoint
+        if (!mode.delta) {
+            bits.put(best_q1[c], 10);
+            continue;
+        }
+
+        bits.put((best_q1[c] - best_q0[c]) & ((1 << mode.delta) - 1), mode.delta);
+        putReversed(bits, best_q0[c], mode.precision - 1, 10);
+    }
+
+    bits.put(best_indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+        bits.put(best_indices[i], 4);
+
+    bits.store(out);
+}
+
+/***********************************************************************/
+
+typedef void (*CompressBlockFunction)(const uchar* pixels, uchar* out);
+
+// One level of one face, where its pixels are and where its blocks go
+struct CompressLevel {
+    const uchar *bits;
+    qsizetype    stride;
+    int          edge;
+    uchar       *dst;
+};
+
+void compressCubemap(const FaceViews& faces, const CubemapMips* mips, BlockFormat format, ThreadPool& pool, CompressedCubemap& out,
+                     BlockQuality quality, int face_mask) {
+
+    out.format = format;
+    out.edge = faces.edge;
+    out.levels = mips ? mips->levels : 1;
+
+    // Lay out every level of every face in DDS order
+    qsizetype total = 0;
+    for (int face = 0; face < 6; ++face)
+        for (int level = 0; level < out.levels; ++level) {
+            const int edge = mipLevelEdge(faces.edge, level);
+            total += compressedLevelBytes(edge, edge, format);
+        }
+    out.data.assign(total, 0);
+
+    const int pixel_bytes = faces.depth / 8;
+
+    std::vector<CompressLevel> levels;
+    uchar* dst = out.data.data();
+    for (int face = 0; face < 6; ++face) {
+
+        const uchar* bits = faces.bits[face];
+        qsizetype stride = faces.stride;
+
+        for (int level = 0; level < out.levels; ++level) {
+            const int edge = mipLevelEdge(faces.edge, level);
+
+            if (!(face_mask & (1 << face))) {
+                dst += compressedLevelBytes(edge, edge, format);
+                continue;
+            }
+
+            // The smaller levels are packed one after the other in the mip chain
+            if (level > 0) {
+                bits = (level == 1) ? mips->faces[face].data() : bits + stride * mipLevelEdge(faces.edge, level - 1);
+                stride = static_cast<qsizetype>(edge) * pixel_bytes;
+            }
+
+            levels.push_back({ bits, stride, edge, dst });
+            dst += compressedLevelBytes(edge, edge, format);
+        }
+    }
+
+    // Every row of blocks is a task, that keeps all cores busy down to the small levels
+    std::vector<std::pair<int, int>> rows;
+    for (int l = 0; l < static_cast<int>(levels.size()); ++l) {
+        const int blocks = std::max(1, (levels[l].edge + 3) / 4);
+        for (int row = 0; row < blocks; ++row)
+            rows.emplace_back(l, row);
+    }
+
+    CompressBlockFunction compress = compressBlockBC7;
+    if (format == BlockFormat::BC1)
+        compress = compressBlockBC1;
+    else if (format == BlockFormat::BC3)
+        compress = compressBlockBC3;
+    const int block_bytes = blockBytes(format);
+
+    pool.parallelFor(static_cast<int>(rows.size()), [&](int task) {
+
+        const CompressLevel& level = levels[rows[task].first];
+        const int block_y = rows[task].second;
+        const int blocks = std::max(1, (level.edge + 3) / 4);
+        uchar* row_dst = level.dst + static_cast<qsizetype>(block_y) * blocks * block_bytes;
+
+        // Room for 16 pixels of either depth
+        quint16 block[16 * 4];
+        quint16 halfs[16 * 4];
+        uchar* pixels = reinterpret_cast<uchar*>(block);
+        for (int block_x = 0; block_x < blocks; ++block_x) {
+
+            // Levels smaller than a block repeat their last row and column
+            for (int y = 0; y < 4; ++y) {
+                const int sy = std::min(block_y * 4 + y, level.edge - 1);
+                const uchar* line = level.bits + sy * level.stride;
+                for (int x = 0; x < 4; ++x) {
+                    const int sx = std::min(block_x * 4 + x, level.edge - 1);
+                    std::copy(line + sx * pixel_bytes, line + (sx + 1) * pixel_bytes, pixels + (y * 4 + x) * pixel_bytes);
+                }
+            }
+
+            if (format == BlockFormat::BC6H) {
+                unormToHalf(block, 16 * 4, halfs);
+                compressBlockBC6H(halfs, row_dst + block_x * block_bytes, quality);
+            }
+            else
+                compress(pixels, row_dst + block_x * block_bytes);
+        }
+    });
+}
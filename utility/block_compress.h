@@ -0,0 +1,89 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef BLOCK_COMPRESS_HPP
+#define BLOCK_COMPRESS_HPP
+
+// C++ and STL includes
+#include <vector>
+
+// Qt includes
+#include <QtGlobal>
+
+#include "thread_pool.h"
+#include "cubemap_convert.h"
+#include "mipmap.h"
+
+// Block compressed formats the DDS can be written in
+enum class BlockFormat {
+    None,       // Uncompressed 32-bit BGRA
+    BC1,        // DXT1, 4 bits per pixel, opaque
+    BC3,        // DXT5, 8 bits per pixel, BC1 colour plus interpolated alpha
+    BC7,        // BC7 mode 6, 8 bits per pixel, much better colour than BC1/BC3
+    BC6H        // BC6H unsigned half float, 8 bits per pixel, for 16-bit cubemaps
+};
+
+// How hard the BC6H encoder searches for endpoints
+enum class BlockQuality {
+    Fast,       // Mode 11 on the principal axis endpoints only
+    Normal,     // All one region modes with a least squares refit
+    Slow        // Plus a search of the neighbouring quantised endpoints
+};
+
+//
+// A cubemap compressed into 4x4 blocks
+//
+// data is the whole DDS payload: each face in DDS order (+X, -X, +Y, -Y, +Z, -Z)
+// followed by its mip levels, every level stored as rows of blocks.
+//
+struct CompressedCubemap {
+    BlockFormat         format = BlockFormat::None;
+    int                 edge = 0;
+    int                 levels = 1;
+    std::vector<uchar>  data;
+};
+
+// Bytes in one 4x4 block, 8 for BC1 and 16 for BC3/BC7
+int blockBytes(BlockFormat format);
+
+// Bytes of a whole compressed level of width x height pixels
+qsizetype compressedLevelBytes(int width, int height, BlockFormat format);
+
+const char* blockFormatName(BlockFormat format);
+
+// Compress one 4x4 block of B, G, R, A pixels (16 pixels, row by row)
+void compressBlockBC1(const uchar* pixels, uchar* out);
+void compressBlockBC3(const uchar* pixels, uchar* out);
+void compressBlockBC7(const uchar* pixels, uchar* out);
+
+// Compress one 4x4 block of R, G, B, A halfs (16 pixels, row by row), alpha is ignored
+void compressBlockBC6H(const quint16* pixels, uchar* out, BlockQuality quality);
+
+// Compress all six faces and their mip chains (if given), rows of blocks are spread over the pool.
+// BC6H needs 64-bit faces, the other formats 32-bit ones.  Faces left out of face_mask keep their
+// place in the layout but are left zero, their mip chains aren't read.
+void compressCubemap(const FaceViews& faces, const CubemapMips* mips, BlockFormat format, ThreadPool& pool, CompressedCubemap& out,
+                     BlockQuality quality = BlockQuality::Normal, int face_mask = CUBEMAP_ALL_FACES);
+
+#endif // BLOCK_COMPRESS_HPP
@@ -0,0 +1,515 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Qt includes
+#include <QColor>
+
+#include "cubemap_convert.h"
+#include "area_filter.h"
+
+// Convert output image coordinates to 3D coordinates
+// This function maps a pixel in a specific face of the cubemap to a 3D vector.
+// The face is determined by the `face` parameter.
+void outImgToXYZ(int i, int j, int face, int edge, float& x, float& y, float& z, CubeProjection projection) {
+
+    // Correctly scale i and j to a -1 to 1 range for each face
+    // i and j are relative to the top-left of the current face
+    float a = 2.0f * (float)i / (float)edge - 1.0f;
+    float b = 2.0f * (float)j / (float)edge - 1.0f;
+
+    // Equi-angular faces step evenly through the angle, -45 to 45 degrees, rather than its tangent
+    if (projection == CubeProjection::EquiAngular) {
+        a = std::tan(a * static_cast<float>(M_PI / 4));
+        b = std::tan(b * static_cast<float>(M_PI / 4));
+    }
+
+    switch (face) {
+
+        // We'll use a standard cubemap face order:
+        // 0: right (+X)
+        // 1: left (-X)
+        // 2: top (+Y)
+        // 3: bottom (-Y)
+        // 4: front (+Z)
+        // 5: back (-Z)
+
+        // Right (+X) face
+        case 0: x = 1.0f; y = -b; z = -a; break; 
+        
+        // Left (-X) face
+        case 1: x = -1.0f; y = -b; z = a; break; 
+        
+        // Top (+Y) face
+        case 2: x = a; y = 1.0f; z = b; break; 
+        
+        // Bottom (-Y) face
+        case 3: x = a; y = -1.0f; z = -b; break; 
+        
+        // Front (+Z) face
+        case 4: x = a; y = -b; z = 1.0f; break; 
+        
+        // Back (-Z) face
+        case 5: x = -a; y = -b; z = -1.0f; break;
+        
+        default: x = y = z = 0; break;
+    }
+}
+
+void cubemapLayoutGrid(CubemapLayout layout, int& columns, int& rows) {
+
+    switch (layout) {
+        case CubemapLayout::Grid3x2:  columns = 3; rows = 2; break;
+        case CubemapLayout::Strip6x1: columns = 6; rows = 1; break;
+        default:                      columns = 4; rows = 3; break;
+    }
+}
+
+QSize cubemapLayoutSize(CubemapLayout layout, int edge) {
+
+    int columns, rows;
+    cubemapLayoutGrid(layout, columns, rows);
+    return QSize(columns * edge, rows * edge);
+}
+
+const char* cubemapLayoutName(CubemapLayout layout) {
+
+    switch (layout) {
+        case CubemapLayout::Grid3x2:  return "3x2";
+        case CubemapLayout::Strip6x1: return "6x1";
+        default:                      return "cross";
+    }
+}
+
+bool detectCubemapLayout(int width, int height, CubemapLayout& layout) {
+
+    for (CubemapLayout candidate : { CubemapLayout::Grid3x2, CubemapLayout::Strip6x1, CubemapLayout::Cross }) {
+        int columns, rows;
+        cubemapLayoutGrid(candidate, columns, rows);
+        if (width > 0 && width % columns == 0 && height == width / columns * rows) {
+            layout = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool checkUnfoldedCubemap(int width, int height, const QString& path) {
+
+    CubemapLayout layout;
+    if (detectCubemapLayout(width, height, layout))
+        return true;
+
+    // Name the nearest size of each layout at this width
+    std::cerr << "Error: " << path.toStdString() << " is " << width << "x" << height
+              << ", which isn't an unfolded cubemap, expected";
+    const CubemapLayout layouts[] = { CubemapLayout::Grid3x2, CubemapLayout::Strip6x1, CubemapLayout::Cross };
+    for (int i = 0; i < 3; ++i) {
+        int columns, rows;
+        cubemapLayoutGrid(layouts[i], columns, rows);
+        const int edge = std::max(1, width / columns);
+        std::cerr << ((i == 0) ? " " : (i == 2) ? " or " : ", ") << columns * edge << "x" << rows * edge
+                  << " (" << cubemapLayoutName(layouts[i]) << ")";
+    }
+    std::cerr << std::endl;
+    return false;
+}
+
+// Find where a face lives in an unfolded image
+// The compact layouts hold the faces in DDS order, row by row.  In the cross we
+// want the Top and Bottom cubes to align vertically with the Front cube.
+// This is a common arrangement. The layout will be:
+//       +---+
+//       | T |
+//   +---+---+---+---+
+//   | L | F | R | B |
+//   +---+---+---+---+
+//       | D |
+//       +---+
+void faceOrigin(int face, int edge, int& x, int& y, CubemapLayout layout) {
+
+    if (layout != CubemapLayout::Cross) {
+        int columns, rows;
+        cubemapLayoutGrid(layout, columns, rows);
+        x = face % columns * edge;
+        y = face / columns * edge;
+        return;
+    }
+
+    switch (face) {
+
+        // Right (+X) face
+        case 0: x = 2 * edge; y = edge; break;
+
+        // Left (-X) face
+        case 1: x = 0; y = edge; break;
+
+        // Top (+Y) face, centered over the Front face
+        case 2: x = edge; y = 0; break;
+
+        // Bottom (-Y) face, centered under the Front face
+        case 3: x = edge; y = 2 * edge; break;
+
+        // Front (+Z) face
+        case 4: x = edge; y = edge; break;
+
+        // Back (-Z) face
+        case 5: x = 3 * edge; y = edge; break;
+
+        default: x = y = 0; break;
+    }
+}
+
+// Longitude of a direction around the y axis, -pi..pi with 0 facing +Z
+float directionLongitude(float x, float z) {
+    return atan2(x, z);
+}
+
+// Latitude of a direction, pi / 2 straight up
+float directionLatitude(float x, float y, float z) {
+    return atan2(y, hypot(x, z));
+}
+
+// Source column of a longitude and source row of a latitude
+float longitudeToSource(float theta, int inW) {
+    return (inW * (theta + M_PI)) / (2 * M_PI);
+}
+
+float latitudeToSource(float phi, int inH) {
+    return (inH * (M_PI / 2.0f - phi)) / M_PI;
+}
+
+// Work out where one texel of a face lands in the equirectangular source
+// This is the expensive part of the conversion (two atan2 and a hypot per
+// texel), and it only depends on the sizes, which is what makes it cacheable.
+void sourcePosition(int face, int edge, int inW, int inH, int i_face, int j_face, float& uf, float& vf,
+                    CubeProjection projection) {
+
+    float x, y, z;
+    outImgToXYZ(i_face, j_face, face, edge, x, y, z, projection);
+
+    // Convert 3D vector to spherical coordinates
+    const float theta = directionLongitude(x, z);
+    const float phi = directionLatitude(x, y, z);
+
+    // Convert spherical coordinates back to equirectangular coordinates
+    uf = longitudeToSource(theta, inW);
+    vf = latitudeToSource(phi, inH);
+}
+
+// Work out where each texel of one face row samples the source image
+void computeSampleRow(int face, int edge, int inW, int inH, int j_face, int i_begin, int i_end, SamplePoint* points,
+                      CubeProjection projection, SphericalRowFunction spherical) {
+
+    if (!spherical) {
+        for (int i_face = i_begin; i_face < i_end; ++i_face) {
+            float uf, vf;
+            sourcePosition(face, edge, inW, inH, i_face, j_face, uf, vf, projection);
+            points[i_face - i_begin] = makeSamplePoint(uf, vf, inW, inH);
+        }
+        return;
+    }
+
+    // The directions of up to a tile of texels are laid out in arrays, so the
+    // row function can turn a whole vector of them into positions at a time
+    float x[CUBEMAP_TILE_SIZE], y[CUBEMAP_TILE_SIZE], z[CUBEMAP_TILE_SIZE];
+    float uf[CUBEMAP_TILE_SIZE], vf[CUBEMAP_TILE_SIZE];
+    for (int i_start = i_begin; i_start < i_end; i_start += CUBEMAP_TILE_SIZE) {
+
+        const int count = std::min(CUBEMAP_TILE_SIZE, i_end - i_start);
+        for (int i = 0; i < count; ++i)
+            outImgToXYZ(i_start + i, j_face, face, edge, x[i], y[i], z[i], projection);
+
+        spherical(x, y, z, count, inW, inH, uf, vf);
+
+        for (int i = 0; i < count; ++i)
+            points[i_start - i_begin + i] = makeSamplePoint(uf[i], vf[i], inW, inH);
+    }
+}
+
+static bool sameSamplePoint(const SamplePoint& a, const SamplePoint& b) {
+    return a.u == b.u && a.v == b.v && a.fu == b.fu && a.fv == b.fv;
+}
+
+FastMathError measureFastMath(int inW, int inH, int edge, SampleKernel kernel) {
+
+    const SphericalRowFunction spherical = sphericalRowFunction(kernel);
+    const SphericalRowFunction scalar = sphericalRowFunction(SampleKernel::Scalar);
+    const int row_step = std::max(1, edge / 256);
+
+    std::vector<float> x(edge), y(edge), z(edge), uf(edge), vf(edge), scalar_uf(edge), scalar_vf(edge);
+    FastMathError error;
+
+    for (int face = 0; face < 6; ++face) {
+        for (int j = 0; j < edge; j += row_step) {
+
+            for (int i = 0; i < edge; ++i)
+                outImgToXYZ(i, j, face, edge, x[i], y[i], z[i]);
+            spherical(x.data(), y.data(), z.data(), edge, inW, inH, uf.data(), vf.data());
+            scalar(x.data(), y.data(), z.data(), edge, inW, inH, scalar_uf.data(), scalar_vf.data());
+
+            for (int i = 0; i < edge; ++i) {
+
+                float exact_u, exact_v;
+                sourcePosition(face, edge, inW, inH, i, j, exact_u, exact_v);
+
+                // Columns wrap around, so positions either side of the seam are close
+                double du = std::fabs(static_cast<double>(uf[i]) - exact_u);
+                du = std::min(du, inW - du);
+                error.max_u = std::max(error.max_u, du);
+                error.max_v = std::max(error.max_v, std::fabs(static_cast<double>(vf[i]) - exact_v));
+
+                const SamplePoint fast = makeSamplePoint(uf[i], vf[i], inW, inH);
+                if (!sameSamplePoint(fast, makeSamplePoint(exact_u, exact_v, inW, inH)))
+                    ++error.differing_points;
+                if (uf[i] != scalar_uf[i] || vf[i] != scalar_vf[i])
+                    ++error.kernel_mismatches;
+                if (!sameSamplePoint(fast, makeSamplePoint(scalar_uf[i], scalar_vf[i], inW, inH)))
+                    ++error.kernel_point_mismatches;
+                ++error.points;
+            }
+        }
+    }
+
+    return error;
+}
+
+bool fastMathWithinBound(const FastMathError& error, int inW, int inH) {
+
+    return error.max_u <= fastMathErrorBound(inW) && error.max_v <= fastMathErrorBound(inH) &&
+           error.kernel_mismatches == 0 && error.kernel_point_mismatches == 0;
+}
+
+// Fill one square tile of a single face in the unfolded output image
+// Every output pixel only depends on the input image, so tiles can be
+// converted in any order, on any thread, and still give identical results.
+// Rows are handled one at a time: the source position of every pixel in the
+// row is looked up (or worked out), then the sampling kernel blends the whole
+// row straight into the output scanline.
+template<typename Pixel, typename RowFunction>
+static void convertTile(const SourceView& source, RowFunction sampleRow, const RemapTable* remap,
+                        CubeProjection projection, SphericalRowFunction spherical, const FaceTargets& targets,
+                        int face, int edge, int tile_x, int tile_y, int tile_size) {
+
+    const int j_end = std::min(tile_y + tile_size, edge);
+    const int i_end = std::min(tile_x + tile_size, edge);
+
+    SamplePoint row_points[CUBEMAP_TILE_SIZE];
+
+    for (int j_face = tile_y; j_face < j_end; ++j_face) {
+
+        const SamplePoint* points = row_points;
+        if (remap)
+            points = remap->row(face, j_face) + tile_x;
+        else
+            computeSampleRow(face, edge, source.width, source.height, j_face, tile_x, i_end, row_points, projection, spherical);
+
+        // Bilinear interpolation of the whole row
+        Pixel* out_line = reinterpret_cast<Pixel*>(targets.bits[face] + j_face * targets.stride);
+        sampleRow(source, points, i_end - tile_x, out_line + tile_x);
+    }
+}
+
+// Main conversion logic
+// The six faces are cut into CUBEMAP_TILE_SIZE square tiles which are handed
+// to the thread pool, so the result is the same for any number of threads.
+bool convertEquirectToFaces(const QImage& image_in, const FaceTargets& targets, int edge, ThreadPool& pool, const ConvertOptions& options) {
+
+    // Sample points can't address rows any further down
+    if (image_in.height() > SAMPLE_MAX_SOURCE_HEIGHT) {
+        std::cerr << "Can't convert a " << image_in.width() << "x" << image_in.height() << " panorama, at most "
+                  << SAMPLE_MAX_SOURCE_HEIGHT << " rows are supported" << std::endl;
+        return false;
+    }
+
+    const int tiles_per_side = (edge + CUBEMAP_TILE_SIZE - 1) / CUBEMAP_TILE_SIZE;
+    const int tiles_per_face = tiles_per_side * tiles_per_side;
+    const int tile_count = 6 * tiles_per_face;
+
+    // The kernels read raw 32-bit scanlines, or 64-bit ones for 16 bits per channel faces.
+    // 24-bit sources such as developed DNGs are read in place rather than converted.
+    // The area filter's pyramid is built from 32-bit sources, so it skips the 24-bit path.
+    const bool wide = (targets.depth == 64);
+    const bool area = (options.filter == SampleFilter::Area);
+    const bool packed = !wide && !area && image_in.format() == QImage::Format_RGB888;
+    const QImage source_image = wide ? makeSourceImage64(image_in) : (packed ? image_in : makeSourceImage(image_in));
+    const SourceView source = makeSourceView(source_image);
+    const SampleKernel kernel = resolveSampleKernel(options.kernel);
+    const SampleRowFunction sampleRow = packed ? sampleRow24Function(kernel) : sampleRowFunction(kernel);
+    const SampleRow64Function sampleRow64 = sampleRow64Function(kernel);
+    const SphericalRowFunction spherical = options.fast_math ? sphericalRowFunction(kernel) : nullptr;
+
+    // A remap table only fits the sizes it was built for, and only holds bilinear sample points
+    const RemapTable* remap = area ? nullptr : options.remap;
+    if (remap && !remap->matches(source.width, source.height, edge, options.projection))
+        remap = nullptr;
+
+    // A ladder of face sizes shares one pyramid, otherwise it's built for this conversion
+    SourcePyramid own_pyramid;
+    const SourcePyramid* pyramid = options.pyramid;
+    if (area && !pyramid) {
+        buildSourcePyramid(source_image, pool, own_pyramid);
+        pyramid = &own_pyramid;
+    }
+
+    std::cout << "Converting " << tile_count << " tiles on " << pool.threadCount() << " threads"
+              << " with the " << sampleKernelName(kernel) << (wide ? " 16-bit" : (packed ? " 24-bit" : "")) << " kernel"
+              << (remap ? " and a cached remap table" : (spherical && !area ? " and fast math" : ""))
+              << (area ? " and the area filter over " + std::to_string(pyramid->levels.size()) + " levels" : "") << std::endl;
+
+    // A callback hears about every percent, the default printout only every tenth
+    std::mutex progress_mutex;
+    std::atomic<int> tiles_done(0);
+    const int progress_step = std::max(1, tile_count / (options.progress ? 100 : 10));
+
+    pool.parallelFor(tile_count, [&](int tile) {
+
+        const int face = tile / tiles_per_face;
+        const int tile_x = (tile % tiles_per_face) % tiles_per_side * CUBEMAP_TILE_SIZE;
+        const int tile_y = (tile % tiles_per_face) / tiles_per_side * CUBEMAP_TILE_SIZE;
+
+        if (area && wide)
+            convertTileArea(*pyramid, sampleRow64, options.projection, targets, face, edge, tile_x, tile_y, CUBEMAP_TILE_SIZE);
+        else if (area)
+            convertTileArea(*pyramid, sampleRow, options.projection, targets, face, edge, tile_x, tile_y, CUBEMAP_TILE_SIZE);
+        else if (wide)
+            convertTile<quint64>(source, sampleRow64, remap, options.projection, spherical, targets, face, edge, tile_x, tile_y, CUBEMAP_TILE_SIZE);
+        else
+            convertTile<QRgb>(source, sampleRow, remap, options.projection, spherical, targets, face, edge, tile_x, tile_y, CUBEMAP_TILE_SIZE);
+
+        const int done = ++tiles_done;
+        if (done % progress_step == 0 || done == tile_count) {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            if (options.progress)
+                (*options.progress)("convert", done, tile_count);
+            else
+                std::cout << "Processed " << done << " of " << tile_count << " tiles" << std::endl;
+        }
+    });
+
+    return true;
+}
+
+bool convertEquirectToCubemap(const QImage& image_in, QImage& image_out, ThreadPool& pool, const ConvertOptions& options) {
+
+    const int outW = image_out.width();
+    const int outH = image_out.height();
+    
+    // The cubemap output image should be a grid of faces, 4x3 for the cross,
+    // so the edge length of a single face is outW over the number of columns.
+    CubemapLayout layout;
+    if (!detectCubemapLayout(outW, outH, layout)) {
+        std::cerr << "Can't convert into a " << outW << "x" << outH << " image, it isn't an unfolded cubemap" << std::endl;
+        return false;
+    }
+    int columns, rows;
+    cubemapLayoutGrid(layout, columns, rows);
+    const int edge = outW / columns;
+
+    std::cout << "Edge length in pixels: " << edge << std::endl;
+    std::cout << "Output image dimensions: " << outW << "x" << outH << " (" << cubemapLayoutName(layout) << ")" << std::endl;
+
+    // Tiles write straight into 32-bit (or 64-bit) pixels, and everything in the cross that isn't a face stays black
+    if (image_out.format() != QImage::Format_RGB32 && image_out.format() != QImage::Format_RGBA64)
+        image_out = image_out.convertToFormat(QImage::Format_RGB32);
+    if (layout == CubemapLayout::Cross)
+        image_out.fill(Qt::black);
+
+    // Grab the pixel pointers once, up front, so no worker ever triggers a detach
+    FaceTargets targets;
+    targets.stride = image_out.bytesPerLine();
+    targets.depth = image_out.depth();
+    uchar* out_bits = image_out.bits();
+    for (int face = 0; face < 6; ++face) {
+        int face_x, face_y;
+        faceOrigin(face, edge, face_x, face_y, layout);
+        targets.bits[face] = out_bits + face_y * targets.stride + face_x * (targets.depth / 8);
+    }
+
+    return convertEquirectToFaces(image_in, targets, edge, pool, options);
+}
+
+bool convertEquirectToFaceStack(const QImage& image_in, QImage& faces, ThreadPool& pool, const ConvertOptions& options) {
+
+    const int edge = faces.width();
+    std::cout << "Edge length in pixels: " << edge << std::endl;
+
+    if (faces.format() != QImage::Format_RGB32 && faces.format() != QImage::Format_RGBA64)
+        faces = faces.convertToFormat(QImage::Format_RGB32);
+
+    // Face f is rows f * edge .. (f + 1) * edge - 1
+    FaceTargets targets;
+    targets.stride = faces.bytesPerLine();
+    targets.depth = faces.depth();
+    uchar* out_bits = faces.bits();
+    for (int face = 0; face < 6; ++face)
+        targets.bits[face] = out_bits + static_cast<qsizetype>(face) * edge * targets.stride;
+
+    return convertEquirectToFaces(image_in, targets, edge, pool, options);
+}
+
+bool unfoldedFaceViews(const QImage& cubemapImage, FaceViews& views) {
+
+    CubemapLayout layout;
+    if (!detectCubemapLayout(cubemapImage.width(), cubemapImage.height(), layout)) {
+        std::cerr << "Error: a " << cubemapImage.width() << "x" << cubemapImage.height()
+                  << " image isn't an unfolded cubemap" << std::endl;
+        return false;
+    }
+    int columns, rows;
+    cubemapLayoutGrid(layout, columns, rows);
+
+    views.edge = cubemapImage.width() / columns;
+    views.stride = cubemapImage.bytesPerLine();
+    views.depth = cubemapImage.depth();
+
+    for (int face = 0; face < 6; ++face) {
+        int face_x, face_y;
+        faceOrigin(face, views.edge, face_x, face_y, layout);
+        views.bits[face] = cubemapImage.constScanLine(face_y) + face_x * (views.depth / 8);
+    }
+
+    return true;
+}
+
+FaceViews faceStackViews(const QImage& faces) {
+
+    FaceViews views;
+    views.edge = faces.width();
+    views.stride = faces.bytesPerLine();
+    views.depth = faces.depth();
+
+    for (int face = 0; face < 6; ++face)
+        views.bits[face] = faces.constScanLine(face * views.edge);
+
+    return views;
+}
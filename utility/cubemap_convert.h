@@ -0,0 +1,163 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef CUBEMAP_CONVERT_HPP
+#define CUBEMAP_CONVERT_HPP
+
+// C++ and STL includes
+#include <functional>
+
+// Qt includes
+#include <QImage>
+
+#include "image_to_cubemap.h"
+#include "thread_pool.h"
+#include "cubemap_sampler.h"
+#include "fast_math.h"
+#include "remap_table.h"
+
+struct SourcePyramid;
+
+// Told how far a stage has got, done out of total units of work (tiles for a conversion).
+// It's called from worker threads, but never from two at once, and only every percent or so.
+typedef std::function<void(const char* stage, qint64 done, qint64 total)> ProgressCallback;
+
+// How the six faces are arranged in an unfolded cubemap image
+enum class CubemapLayout {
+    Cross,      // 4x3 cross around the front face for editing by hand, half of it is black
+    Grid3x2,    // +X, -X, +Y over -Y, +Z, -Z, nothing wasted
+    Strip6x1    // All six side by side in DDS order
+};
+
+// How each texel reads the source
+enum class SampleFilter {
+    Bilinear,   // One 2x2 tap, sharp but aliases where a texel covers many source pixels
+    Area        // Taps across the texel's footprint in a prefiltered source pyramid
+};
+
+// How an equirectangular image is turned into cube faces
+struct ConvertOptions {
+    SampleKernel          kernel = SampleKernel::Auto;
+    SampleFilter          filter = SampleFilter::Bilinear;
+    CubeProjection        projection = CubeProjection::Standard;
+    bool                  fast_math = false;    // Polynomial atan2 and hypot for source positions, bilinear only
+    const RemapTable     *remap = nullptr;      // Precomputed source positions, or null to compute them, bilinear only
+    const SourcePyramid  *pyramid = nullptr;    // Prebuilt pyramid of the source for the area filter, or null to build it
+    const ProgressCallback *progress = nullptr; // Told as tiles finish, or null to print every tenth of them
+};
+
+// Where the rows of each face go, face f row j starts at bits[f] + j * stride
+struct FaceTargets {
+    uchar     *bits[6];
+    qsizetype  stride;
+    int        depth = 32;      // 32 for RGB32 faces, 64 for RGBA64 faces
+};
+
+// Where the rows of each face are read from, face f row j starts at bits[f] + j * stride
+struct FaceViews {
+    const uchar *bits[6];
+    qsizetype    stride;
+    int          edge;
+    int          depth;         // 32 for RGB32 faces, 64 for RGBA64 faces
+};
+
+// Face edge for an input image, edge_percent of the usual quarter of its width
+inline int cubemapEdge(int input_width, int edge_percent = 100) {
+    return std::max(1, static_cast<int>(static_cast<qint64>(input_width) * edge_percent / 400));
+}
+
+// Convert output image coordinates to 3D coordinates
+void outImgToXYZ(int i, int j, int face, int edge, float& x, float& y, float& z,
+                 CubeProjection projection = CubeProjection::Standard);
+
+// Columns and rows of faces in a layout, and the size of an unfolded image with faces of edge pixels
+void cubemapLayoutGrid(CubemapLayout layout, int& columns, int& rows);
+QSize cubemapLayoutSize(CubemapLayout layout, int edge);
+const char* cubemapLayoutName(CubemapLayout layout);
+
+// Tell the layout of an unfolded image from its shape, false if it isn't exactly
+// 3x2, 6x1 or 4x3 (the cross) square faces, so isn't an unfolded cubemap at all
+bool detectCubemapLayout(int width, int height, CubemapLayout& layout);
+
+// Whether a width x height image read from path is an unfolded cubemap, printing
+// the sizes it could have been when it isn't
+bool checkUnfoldedCubemap(int width, int height, const QString& path);
+
+// Find where a face lives in an unfolded image
+void faceOrigin(int face, int edge, int& x, int& y, CubemapLayout layout = CubemapLayout::Cross);
+
+// The longitude and latitude of a direction, and the column and row they land on in an
+// inW x inH source.  sourcePosition() is made of these, anything working out positions
+// its own way calls them too so its results are bit for bit the same.
+float directionLongitude(float x, float z);
+float directionLatitude(float x, float y, float z);
+float longitudeToSource(float theta, int inW);
+float latitudeToSource(float phi, int inH);
+
+// Work out where texel (i_face, j_face) of a face lands in the source, in source pixels
+void sourcePosition(int face, int edge, int inW, int inH, int i_face, int j_face, float& uf, float& vf,
+                    CubeProjection projection = CubeProjection::Standard);
+
+// Work out where texels i_begin .. i_end - 1 of row j_face of a face sample the source,
+// with libm or, when a spherical row function is given, with its polynomials
+void computeSampleRow(int face, int edge, int inW, int inH, int j_face, int i_begin, int i_end, SamplePoint* points,
+                      CubeProjection projection = CubeProjection::Standard, SphericalRowFunction spherical = nullptr);
+
+// How far the fast math source positions of a kernel are from the exact ones, in source pixels
+struct FastMathError {
+    double max_u = 0.0;                 // Columns either way round the seam
+    double max_v = 0.0;
+    qint64 points = 0;
+    qint64 differing_points = 0;        // Sample points whose pixel or 8-bit weights changed
+    qint64 kernel_mismatches = 0;       // Positions where the kernel and the scalar one disagree
+    qint64 kernel_point_mismatches = 0; // Sample points where the kernel and the scalar one disagree
+};
+
+// Compare the fast math positions of every texel in up to 256 rows of each face of edge
+// pixels with the exact ones, and with the scalar kernel's
+FastMathError measureFastMath(int inW, int inH, int edge, SampleKernel kernel);
+
+// Whether a measurement is within fastMathErrorBound() of the exact positions for an
+// inW x inH source, and the kernel agrees exactly with the scalar one
+bool fastMathWithinBound(const FastMathError& error, int inW, int inH);
+
+// Conversions fail, with an error, for sources more than SAMPLE_MAX_SOURCE_HEIGHT rows tall
+
+// Fill the six faces of edge pixels wherever the targets point
+bool convertEquirectToFaces(const QImage& image_in, const FaceTargets& targets, int edge, ThreadPool& pool, const ConvertOptions& options);
+
+// Fill an unfolded cubemap image from an equirectangular image, in the layout its shape
+// makes it.  An RGBA64 output image keeps 16 bits per channel, anything else is made RGB32
+bool convertEquirectToCubemap(const QImage& image_in, QImage& image_out, ThreadPool& pool, const ConvertOptions& options);
+
+// Fill an edge x (6 * edge) RGB32 (or RGBA64) image holding the faces top to bottom
+// in DDS order (+X, -X, +Y, -Y, +Z, -Z), RGB32 pixel bytes are exactly the DDS payload
+bool convertEquirectToFaceStack(const QImage& image_in, QImage& faces, ThreadPool& pool, const ConvertOptions& options);
+
+// View the faces of a 32 or 64-bit unfolded cubemap (in any layout), false with an
+// error if the image isn't one, or of a face stack in DDS order
+bool unfoldedFaceViews(const QImage& cubemapImage, FaceViews& views);
+FaceViews faceStackViews(const QImage& faces);
+
+#endif // CUBEMAP_CONVERT_HPP
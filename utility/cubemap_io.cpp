@@ -0,0 +1,574 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Include libraw for DNG import
+#include <libraw/libraw.h>
+
+// Qt includes
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+
+#include "image_to_cubemap.h"
+#include "cubemap_io.h"
+#include "cubemap_convert.h"
+#include "half_float.h"
+#include "dds_file.h"
+#include "strip_reader.h"
+#include "thread_pool.h"
+
+//
+// Develop an opened DNG with libraw into a QImage
+//
+static QImage developDNG(LibRaw& rawProcessor, bool high_bit_depth) {
+
+    // For high bit depth output keep 16 bits per channel in linear light, and
+    // don't let auto brightness clip the highlights we are keeping
+    const int bits = high_bit_depth ? 16 : 8;
+    if (high_bit_depth) {
+        rawProcessor.imgdata.params.output_bps = 16;
+        rawProcessor.imgdata.params.gamm[0] = 1.0;
+        rawProcessor.imgdata.params.gamm[1] = 1.0;
+        rawProcessor.imgdata.params.no_auto_bright = 1;
+    }
+
+    // Unpack DNG
+    rawProcessor.unpack();
+    rawProcessor.dcraw_process();
+
+    // Get a handle to the image data
+    libraw_processed_image_t* image = rawProcessor.dcraw_make_mem_image();
+
+    // Is this an RGB DNG with the bits per component we asked for?
+    if (!image || image->colors != 3 || image->bits != bits) {
+        if (image)
+            LibRaw::dcraw_clear_mem(image);
+        return QImage();
+    }
+
+    // Yes, create a new QImage with the DNG data
+    QImage qimg;
+    if (high_bit_depth) {
+
+        // 16-bit RGB in host byte order, padded out to RGBX64
+        qimg = QImage(image->width, image->height, QImage::Format_RGBX64);
+        const quint16* src = reinterpret_cast<const quint16*>(image->data);
+        for (int y = 0; y < image->height; ++y) {
+            quint16* line = reinterpret_cast<quint16*>(qimg.scanLine(y));
+            for (int x = 0; x < image->width; ++x, src += 3) {
+                line[x * 4 + 0] = src[0];
+                line[x * 4 + 1] = src[1];
+                line[x * 4 + 2] = src[2];
+                line[x * 4 + 3] = 0xFFFF;
+            }
+        }
+        LibRaw::dcraw_clear_mem(image);
+    }
+    else {
+        // 8-bit RGB is used in place, libraw's buffer is freed along with the last copy of the image
+        qimg = QImage(image->data, image->width, image->height, static_cast<qsizetype>(image->width) * 3, QImage::Format_RGB888,
+                      [](void* info) { LibRaw::dcraw_clear_mem(static_cast<libraw_processed_image_t*>(info)); }, image);
+    }
+
+    // Cleanup
+    rawProcessor.recycle();
+    return qimg;
+}
+
+//
+// Function to load a DNG using libraw as a QImage
+//
+QImage loadDNG(const QString& path, bool high_bit_depth) {
+
+    // Map the raw DNG file, libraw then unpacks it straight from the page cache
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QImage();
+    const uchar* mapped = file.map(0, file.size());
+
+    LibRaw rawProcessor;
+    const int opened = mapped ? rawProcessor.open_buffer(mapped, static_cast<size_t>(file.size()))
+                              : rawProcessor.open_file(path.toUtf8().data());
+    if (opened != LIBRAW_SUCCESS)
+        return QImage();
+
+    return developDNG(rawProcessor, high_bit_depth);
+}
+
+//
+// Function to load a quick, smaller look at a DNG
+//
+// The embedded JPEG preview is all that's decoded when it's a whole 2:1 panorama
+// of at least PREVIEW_MIN_WIDTH pixels.  Otherwise libraw develops the raw at
+// half size, which takes each 2x2 Bayer quad as one pixel and skips demosaicing.
+//
+QImage loadDNGPreview(const QString& path, bool high_bit_depth) {
+
+    LibRaw rawProcessor;
+    if (rawProcessor.open_file(path.toUtf8().data()) != LIBRAW_SUCCESS)
+        return QImage();
+
+    // The embedded preview is only 8-bit
+    if (!high_bit_depth && rawProcessor.unpack_thumb() == LIBRAW_SUCCESS) {
+
+        libraw_processed_image_t* thumb = rawProcessor.dcraw_make_mem_thumb();
+        QImage preview;
+        if (thumb && thumb->type == LIBRAW_IMAGE_JPEG)
+            preview.loadFromData(thumb->data, static_cast<int>(thumb->data_size), "JPG");
+        if (thumb)
+            LibRaw::dcraw_clear_mem(thumb);
+
+        if (!preview.isNull() && preview.width() >= PREVIEW_MIN_WIDTH && preview.width() == 2 * preview.height())
+            return preview;
+    }
+
+    rawProcessor.imgdata.params.half_size = 1;
+    return developDNG(rawProcessor, high_bit_depth);
+}
+
+//
+// Function to tag a DDS header with the projection of its faces
+//
+// DDS has no field for this, so equi-angular faces are marked with a FourCC in a
+// reserved entry that readers otherwise ignore.  Tools that don't know the tag
+// still load the file, they just show the faces slightly pinched.
+//
+static void setHeaderProjection(DDS_HEADER& header, CubeProjection projection) {
+    header.dwReserved1[DDS_PROJECTION_SLOT] = (projection == CubeProjection::EquiAngular) ? FOURCC_EAC : 0;
+}
+
+//
+// Function to fill in the DDS header of an uncompressed 32-bit cubemap
+//
+DDS_HEADER makeCubemapHeader(int edge, int mip_levels, CubeProjection projection) {
+
+    int bytesPerPixel = 4; // For RGBA8888
+
+    DDS_HEADER header = {};
+    header.dwSize = sizeof(DDS_HEADER);
+    header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_PITCH;
+    header.dwHeight = edge;
+    header.dwWidth = edge;
+    header.dwPitchOrLinearSize = edge * bytesPerPixel;
+    header.dwMipMapCount = mip_levels;
+    header.ddspf.dwSize = sizeof(DDS_PIXELFORMAT);
+    header.ddspf.dwFlags = DDPF_RGB | DDPF_ALPHAPIXELS;
+    header.ddspf.dwRGBBitCount = 32;
+    header.ddspf.dwRBitMask = 0x00FF0000;
+    header.ddspf.dwGBitMask = 0x0000FF00;
+    header.ddspf.dwBBitMask = 0x000000FF;
+    header.ddspf.dwABitMask = 0xFF000000;
+    header.dwCaps = DDSCAPS_COMPLEX | DDSCAPS_TEXTURE;
+    header.dwCaps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES;
+    setHeaderProjection(header, projection);
+
+    // Each face is then followed by its own chain of smaller levels
+    if (mip_levels > 1) {
+        header.dwFlags |= DDSD_MIPMAPCOUNT;
+        header.dwCaps |= DDSCAPS_MIPMAP;
+    }
+
+    return header;
+}
+
+//
+// Function to fill in the DDS header of a block compressed cubemap
+//
+DDS_HEADER makeCompressedCubemapHeader(int edge, int mip_levels, BlockFormat format, CubeProjection projection) {
+
+    DDS_HEADER header = {};
+    header.dwSize = sizeof(DDS_HEADER);
+    header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+    header.dwHeight = edge;
+    header.dwWidth = edge;
+    header.dwPitchOrLinearSize = static_cast<quint32>(compressedLevelBytes(edge, edge, format));
+    header.dwMipMapCount = mip_levels;
+    header.ddspf.dwSize = sizeof(DDS_PIXELFORMAT);
+    header.ddspf.dwFlags = DDPF_FOURCC;
+    header.dwCaps = DDSCAPS_COMPLEX | DDSCAPS_TEXTURE;
+    header.dwCaps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES;
+    setHeaderProjection(header, projection);
+
+    // BC7 and BC6H have no FourCC of their own, they're described by the DX10 header that follows
+    if (format == BlockFormat::BC1)
+        header.ddspf.dwFourCC = FOURCC_DXT1;
+    else if (format == BlockFormat::BC3)
+        header.ddspf.dwFourCC = FOURCC_DXT5;
+    else
+        header.ddspf.dwFourCC = FOURCC_DX10;
+
+    if (mip_levels > 1) {
+        header.dwFlags |= DDSD_MIPMAPCOUNT;
+        header.dwCaps |= DDSCAPS_MIPMAP;
+    }
+
+    return header;
+}
+
+DDS_HEADER_DXT10 makeCubemapHeaderDXT10(quint32 dxgi_format) {
+
+    DDS_HEADER_DXT10 header = {};
+    header.dxgiFormat = dxgi_format;
+    header.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    header.miscFlag = DDS_RESOURCE_MISC_TEXTURECUBE;
+    header.arraySize = 1; // One cube, the six faces are implied
+    return header;
+}
+
+//
+// Function to fill in the DDS header of an RGBA16F cubemap, the format itself is in the DX10 header
+//
+DDS_HEADER makeHalfCubemapHeader(int edge, int mip_levels, CubeProjection projection) {
+
+    DDS_HEADER header = makeCubemapHeader(edge, mip_levels, projection);
+    header.dwPitchOrLinearSize = edge * 8;
+    header.ddspf.dwFlags = DDPF_FOURCC;
+    header.ddspf.dwFourCC = FOURCC_DX10;
+    header.ddspf.dwRGBBitCount = 0;
+    header.ddspf.dwRBitMask = 0;
+    header.ddspf.dwGBitMask = 0;
+    header.ddspf.dwBBitMask = 0;
+    header.ddspf.dwABitMask = 0;
+    return header;
+}
+
+//
+// Function to open a DDS for writing the faces in face_mask
+//
+// Writing every face creates the file at its full size.  Otherwise the existing
+// DDS is updated in place, so it has to be exactly as long as the full file would
+// be.  When it isn't, the other faces' mips and blocks were never built, so the
+// update is refused rather than widened to every face here.
+//
+static bool openDDS(DDSFile& file, const QString& path, qint64 total_bytes, int face_mask) {
+
+    if (face_mask != CUBEMAP_ALL_FACES && QFileInfo(path).size() != total_bytes) {
+        std::cerr << "Existing DDS doesn't match the faces being updated: " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    return file.open(path, total_bytes, face_mask != CUBEMAP_ALL_FACES);
+}
+
+// Bytes of one face with its mip chain, uncompressed
+static qint64 faceChainBytes(int edge, int levels, int pixel_bytes) {
+
+    qint64 bytes = 0;
+    for (int level = 0; level < levels; ++level) {
+        const qint64 level_edge = mipLevelEdge(edge, level);
+        bytes += level_edge * level_edge * pixel_bytes;
+    }
+    return bytes;
+}
+
+// Run the write tasks on the pool if there is one, otherwise one after the other on this thread
+static void runWriteTasks(ThreadPool* pool, int count, const std::function<void(int)>& task) {
+
+    if (pool) {
+        pool->parallelFor(count, task);
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+        task(i);
+}
+
+//
+// A part of the DDS that one task writes: a band of up to CUBEMAP_TILE_SIZE
+// rows of a face, or the whole mip chain that follows the face
+//
+struct FaceRegion {
+    int face;
+    int band;
+};
+
+const int FACE_REGION_CHAIN = -1;
+
+static std::vector<FaceRegion> faceRegions(int edge, int face_mask, bool mips) {
+
+    const int bands = (edge + CUBEMAP_TILE_SIZE - 1) / CUBEMAP_TILE_SIZE;
+
+    std::vector<FaceRegion> regions;
+    for (int face = 0; face < 6; ++face) {
+        if (!(face_mask & (1 << face)))
+            continue;
+        for (int band = 0; band < bands; ++band)
+            regions.push_back({ face, band });
+        if (mips)
+            regions.push_back({ face, FACE_REGION_CHAIN });
+    }
+    return regions;
+}
+
+//
+// Function to write 32-bit faces (and their mips) as a DDS file
+//
+// A 32-bit RGB32/ARGB32 pixel is stored as B, G, R, A bytes, which is exactly
+// the DDS pixel format, so every band of face rows goes straight into the file
+// (gathered into one write when the rows aren't contiguous) from its own task.
+//
+static bool writeFacesToDDS(const FaceViews& faces, const CubemapMips* mips, const QString& save_file_path,
+                            CubeProjection projection, int face_mask, ThreadPool* pool) {
+
+    const int edge = faces.edge;
+    const int levels = mips ? mips->levels : 1;
+    const qsizetype row_bytes = static_cast<qsizetype>(edge) * 4;
+    const qint64 data_offset = sizeof(quint32) + sizeof(DDS_HEADER);
+    const qint64 face_bytes = faceChainBytes(edge, levels, 4);
+
+    DDSFile file;
+    if (!openDDS(file, save_file_path, data_offset + 6 * face_bytes, face_mask))
+        return false;
+
+    // 1. The magic number and header
+    const DDS_HEADER header = makeCubemapHeader(edge, levels, projection);
+    file.write(0, &DDS_MAGIC, sizeof(quint32));
+    file.write(sizeof(quint32), &header, sizeof(DDS_HEADER));
+
+    // 2. Pixel data for each face in DDS order: +X, -X, +Y, -Y, +Z, -Z, each
+    // followed by the rest of its mip chain.  Faces left out of face_mask are
+    // already up to date in the file.
+    const std::vector<FaceRegion> regions = faceRegions(edge, face_mask, mips != nullptr);
+    runWriteTasks(pool, static_cast<int>(regions.size()), [&](int r) {
+
+        const int face = regions[r].face;
+        const qint64 face_offset = data_offset + face * face_bytes;
+
+        if (regions[r].band == FACE_REGION_CHAIN) {
+            file.write(face_offset + row_bytes * edge, mips->faces[face].data(), static_cast<qint64>(mips->faces[face].size()));
+            return;
+        }
+
+        const int first_row = regions[r].band * CUBEMAP_TILE_SIZE;
+        const int rows = std::min(CUBEMAP_TILE_SIZE, edge - first_row);
+        const uchar* bits = faces.bits[face] + first_row * faces.stride;
+        const qint64 offset = face_offset + first_row * row_bytes;
+
+        if (faces.stride == row_bytes) {
+            file.write(offset, bits, rows * row_bytes);
+            return;
+        }
+
+        std::vector<uchar> band(static_cast<size_t>(rows) * row_bytes);
+        for (int row = 0; row < rows; ++row)
+            std::memcpy(band.data() + row * row_bytes, bits + row * faces.stride, row_bytes);
+        file.write(offset, band.data(), static_cast<qint64>(band.size()));
+    });
+
+    return file.close();
+}
+
+//
+// Function to write provided QImage as a DDS file to the save_file_path provided
+//
+bool writeCubemapToDDS(const QImage& cubemapImage, const QString& save_file_path, const CubemapMips* mips,
+                       CubeProjection projection, int face_mask, ThreadPool* pool) {
+
+    // Faces are written straight out of the unfolded image when it already holds B, G, R, A pixels
+    const QImage img = (cubemapImage.format() == QImage::Format_RGB32 || cubemapImage.format() == QImage::Format_ARGB32)
+        ? cubemapImage : cubemapImage.convertToFormat(QImage::Format_RGB32);
+
+    FaceViews faces;
+    if (!unfoldedFaceViews(img, faces))
+        return false;
+    return writeFacesToDDS(faces, mips, save_file_path, projection, face_mask, pool);
+}
+
+//
+// Function to write a face stack (faces top to bottom in DDS order) as a DDS file
+//
+bool writeFaceStackToDDS(const QImage& faces, const QString& save_file_path, const CubemapMips* mips,
+                         CubeProjection projection, ThreadPool* pool) {
+
+    return writeFacesToDDS(faceStackViews(faces), mips, save_file_path, projection, CUBEMAP_ALL_FACES, pool);
+}
+
+//
+// Function to write a block compressed cubemap as a DDS file
+//
+bool writeCompressedCubemapToDDS(const CompressedCubemap& cubemap, const QString& save_file_path, CubeProjection projection,
+                                 int face_mask, ThreadPool* pool) {
+
+    const DDS_HEADER header = makeCompressedCubemapHeader(cubemap.edge, cubemap.levels, cubemap.format, projection);
+    const bool dx10 = (header.ddspf.dwFourCC == FOURCC_DX10);
+    const qint64 data_offset = sizeof(quint32) + sizeof(DDS_HEADER) + (dx10 ? sizeof(DDS_HEADER_DXT10) : 0);
+
+    DDSFile file;
+    if (!openDDS(file, save_file_path, data_offset + static_cast<qint64>(cubemap.data.size()), face_mask))
+        return false;
+
+    file.write(0, &DDS_MAGIC, sizeof(quint32));
+    file.write(sizeof(quint32), &header, sizeof(DDS_HEADER));
+
+    if (dx10) {
+        const DDS_HEADER_DXT10 header_dx10 = makeCubemapHeaderDXT10(cubemap.format == BlockFormat::BC6H ? DXGI_FORMAT_BC6H_UF16 : DXGI_FORMAT_BC7_UNORM);
+        file.write(sizeof(quint32) + sizeof(DDS_HEADER), &header_dx10, sizeof(DDS_HEADER_DXT10));
+    }
+
+    // The blocks already are laid out face by face with their mips, every face takes the
+    // same bytes, which are written in chunks so the big faces spread over the pool too
+    const qint64 face_bytes = static_cast<qint64>(cubemap.data.size()) / 6;
+    const qint64 chunk_bytes = 1 << 20;
+    const int chunks = static_cast<int>((face_bytes + chunk_bytes - 1) / chunk_bytes);
+
+    std::vector<std::pair<int, int>> regions;
+    for (int face = 0; face < 6; ++face)
+        if (face_mask & (1 << face))
+            for (int chunk = 0; chunk < chunks; ++chunk)
+                regions.emplace_back(face, chunk);
+
+    runWriteTasks(pool, static_cast<int>(regions.size()), [&](int r) {
+        const qint64 offset = regions[r].first * face_bytes + regions[r].second * chunk_bytes;
+        file.write(data_offset + offset, cubemap.data.data() + offset, std::min(chunk_bytes, face_bytes - regions[r].second * chunk_bytes));
+    });
+
+    return file.close();
+}
+
+//
+// Function to write RGBA64 faces (and mips) as an RGBA16F DDS file
+//
+bool writeHalfCubemapToDDS(const FaceViews& faces, const CubemapMips* mips, const QString& save_file_path,
+                           CubeProjection projection, int face_mask, ThreadPool* pool) {
+
+    const int edge = faces.edge;
+    const int levels = mips ? mips->levels : 1;
+    const qsizetype row_bytes = static_cast<qsizetype>(edge) * 8;
+    const qint64 data_offset = sizeof(quint32) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+    const qint64 face_bytes = faceChainBytes(edge, levels, 8);
+
+    DDSFile file;
+    if (!openDDS(file, save_file_path, data_offset + 6 * face_bytes, face_mask))
+        return false;
+
+    const DDS_HEADER header = makeHalfCubemapHeader(edge, levels, projection);
+    const DDS_HEADER_DXT10 header_dx10 = makeCubemapHeaderDXT10(DXGI_FORMAT_R16G16B16A16_FLOAT);
+
+    file.write(0, &DDS_MAGIC, sizeof(quint32));
+    file.write(sizeof(quint32), &header, sizeof(DDS_HEADER));
+    file.write(sizeof(quint32) + sizeof(DDS_HEADER), &header_dx10, sizeof(DDS_HEADER_DXT10));
+
+    // Channels are already R, G, B, A, they just go from 16-bit integers to halfs,
+    // a band of rows (or a whole packed mip chain) per task
+    const std::vector<FaceRegion> regions = faceRegions(edge, face_mask, mips != nullptr);
+    runWriteTasks(pool, static_cast<int>(regions.size()), [&](int r) {
+
+        const int face = regions[r].face;
+        const qint64 face_offset = data_offset + face * face_bytes;
+
+        if (regions[r].band == FACE_REGION_CHAIN) {
+            const std::vector<uchar>& chain = mips->faces[face];
+            std::vector<quint16> halfs(chain.size() / 2);
+            unormToHalf(reinterpret_cast<const quint16*>(chain.data()), static_cast<int>(halfs.size()), halfs.data());
+            file.write(face_offset + row_bytes * edge, halfs.data(), static_cast<qint64>(chain.size()));
+            return;
+        }
+
+        const int first_row = regions[r].band * CUBEMAP_TILE_SIZE;
+        const int rows = std::min(CUBEMAP_TILE_SIZE, edge - first_row);
+
+        std::vector<quint16> band(static_cast<size_t>(rows) * edge * 4);
+        for (int row = 0; row < rows; ++row)
+            unormToHalf(reinterpret_cast<const quint16*>(faces.bits[face] + (first_row + row) * faces.stride), edge * 4,
+                        band.data() + static_cast<size_t>(row) * edge * 4);
+        file.write(face_offset + first_row * row_bytes, band.data(), rows * row_bytes);
+    });
+
+    return file.close();
+}
+
+//
+// Function to load an equirectangular (or unfolded) image, DNGs go through libraw
+//
+QImage loadInputImage(const QString& path, bool high_bit_depth, bool preview, int min_width) {
+
+    QImage image;
+    const QString extension = QFileInfo(path).suffix().toLower();
+
+    // Are we reading raw?
+    if (extension == "dng") {
+        image = preview ? loadDNGPreview(path, high_bit_depth) : loadDNG(path, high_bit_depth);
+    }
+    else if (preview) {
+
+        // Let the decoder scale down while it reads, JPEGs then skip most of the IDCT work
+        QImageReader reader(path);
+        const QSize size = reader.size();
+        if (size.isValid() && size.width() > PREVIEW_WIDTH)
+            reader.setScaledSize(QSize(PREVIEW_WIDTH, qMax(1, size.height() * PREVIEW_WIDTH / size.width())));
+        image = reader.read();
+    }
+    // A JPEG much wider than needed goes through libjpeg's scaled IDCT, straight into a Format_RGB32 image
+    else if ((extension == "jpg" || extension == "jpeg") && jpegScaleDenominator(QImageReader(path).size().width(), min_width) > 1) {
+
+        // Anything libjpeg can't open is left to Qt, which also sniffs misnamed files
+        std::unique_ptr<StripReader> reader = openStripReader(path, min_width);
+        if (!reader) {
+            if (!image.load(path))
+                return QImage();
+        }
+        else {
+            image = QImage(reader->width(), reader->height(), QImage::Format_RGB32);
+            if (image.isNull() || !reader->readRows(image.bits(), image.bytesPerLine(), image.height()))
+                return QImage();
+        }
+    }
+    // No, load the PNG/JPG file
+    else if (!image.load(path)) {
+        return QImage();
+    }
+
+    // Previews are never wider than PREVIEW_WIDTH, which keeps their faces small
+    if (preview && image.width() > PREVIEW_WIDTH)
+        image = image.scaled(PREVIEW_WIDTH, qMax(1, image.height() * PREVIEW_WIDTH / image.width()),
+                             Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    return image;
+}
+
+//
+// Function to find the pixel size of an input image without decoding it
+//
+QSize probeImageSize(const QString& path) {
+
+    if (QFileInfo(path).suffix().toLower() == "dng") {
+
+        // libraw reads the sizes from the metadata when the file is opened
+        LibRaw rawProcessor;
+        if (rawProcessor.open_file(path.toUtf8().data()) != LIBRAW_SUCCESS)
+            return QSize();
+
+        QSize size(rawProcessor.imgdata.sizes.width, rawProcessor.imgdata.sizes.height);
+        rawProcessor.recycle();
+        return size;
+    }
+
+    return QImageReader(path).size();
+}
@@ -0,0 +1,91 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef CUBEMAP_IO_HPP
+#define CUBEMAP_IO_HPP
+
+// Qt includes
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+#include "image_to_cubemap.h"
+#include "mipmap.h"
+#include "block_compress.h"
+
+class ThreadPool;
+
+// Load a DNG using libraw as a QImage, 8-bit RGB888 or 16-bit linear RGBX64
+QImage loadDNG(const QString& path, bool high_bit_depth = false);
+
+// Load a quick look at a DNG, the embedded preview or a half size develop
+QImage loadDNGPreview(const QString& path, bool high_bit_depth = false);
+
+// Load any supported input image, returns a null image on failure.
+// A preview is loaded as fast as possible and at most PREVIEW_WIDTH wide.
+// Given a min_width, a JPEG that is at least twice as wide is decoded at
+// 1/2, 1/4 or 1/8 scale, the smallest that still covers min_width.
+QImage loadInputImage(const QString& path, bool high_bit_depth = false, bool preview = false, int min_width = 0);
+
+// Find the pixel size of an input image without decoding it, invalid if unknown
+QSize probeImageSize(const QString& path);
+
+// Fill in the DDS header of an uncompressed 32-bit cubemap with faces of edge pixels
+DDS_HEADER makeCubemapHeader(int edge, int mip_levels = 1, CubeProjection projection = CubeProjection::Standard);
+
+// Fill in the DDS header of a block compressed cubemap, BC7 also needs the DX10 header
+DDS_HEADER makeCompressedCubemapHeader(int edge, int mip_levels, BlockFormat format,
+                                       CubeProjection projection = CubeProjection::Standard);
+DDS_HEADER_DXT10 makeCubemapHeaderDXT10(quint32 dxgi_format);
+
+// Fill in the DDS header of an RGBA16F cubemap, followed by a DX10 header
+DDS_HEADER makeHalfCubemapHeader(int edge, int mip_levels = 1, CubeProjection projection = CubeProjection::Standard);
+
+// The writers tag equi-angular faces in the header, see FOURCC_EAC.  Those taking a
+// face_mask only write the faces in it into an existing DDS of the same layout and
+// leave the others as they are.  A DDS of any other size is refused, so which faces
+// to write has to be settled before their mips and blocks are built, as
+// staleCubemapFaces() does.  The file is sized up front and, given a pool, its faces
+// are written by several threads at once.
+
+// Write an unfolded cubemap (cross, 3x2 or 6x1) as a DDS file, with the smaller mip levels if given
+bool writeCubemapToDDS(const QImage& cubemapImage, const QString& save_file_path, const CubemapMips* mips = nullptr,
+                       CubeProjection projection = CubeProjection::Standard, int face_mask = CUBEMAP_ALL_FACES,
+                       ThreadPool* pool = nullptr);
+
+// Write an RGB32 face stack from convertEquirectToFaceStack() as a DDS file, with the smaller mip levels if given
+bool writeFaceStackToDDS(const QImage& faces, const QString& save_file_path, const CubemapMips* mips = nullptr,
+                         CubeProjection projection = CubeProjection::Standard, ThreadPool* pool = nullptr);
+
+// Write 64-bit RGBA64 faces (and their mips) as an RGBA16F DDS file
+bool writeHalfCubemapToDDS(const FaceViews& faces, const CubemapMips* mips, const QString& save_file_path,
+                           CubeProjection projection = CubeProjection::Standard, int face_mask = CUBEMAP_ALL_FACES,
+                           ThreadPool* pool = nullptr);
+
+// Write a block compressed cubemap from compressCubemap() as a DDS file
+bool writeCompressedCubemapToDDS(const CompressedCubemap& cubemap, const QString& save_file_path,
+                                 CubeProjection projection = CubeProjection::Standard, int face_mask = CUBEMAP_ALL_FACES,
+                                 ThreadPool* pool = nullptr);
+
+#endif // CUBEMAP_IO_HPP
@@ -0,0 +1,672 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+#include <cmath>
+
+// x86 SIMD intrinsics, other CPUs use the scalar kernel
+#if defined(__x86_64__) || defined(__i386__)
+#define CUBEMAP_SAMPLER_X86 1
+#include <immintrin.h>
+#endif
+
+#include "cubemap_sampler.h"
+
+//
+// All kernels do exactly the same fixed-point arithmetic, so they produce
+// identical bytes.  Each channel is blended vertically, rounded, then
+// blended horizontally and rounded again:
+//
+//     left  = (A * (256 - fv) + C * fv + 128) >> 8
+//     right = (B * (256 - fv) + D * fv + 128) >> 8
+//     out   = (left * (256 - fu) + right * fu + 128) >> 8
+//
+// where A B are the top row and C D the bottom row.  Every intermediate fits
+// in 16 unsigned bits, which is what lets the SIMD kernels work on 16-bit lanes.
+// Alpha is always forced to opaque.
+//
+// The 24-bit (RGB888) kernels widen their taps to RGB32 and then blend them
+// just like the 32-bit ones, so a source reads the same either way.
+//
+// The 64-bit (RGBA64) kernels do the very same arithmetic on 16-bit channels,
+// where the intermediates need 32-bit lanes instead.
+//
+
+SamplePoint makeSamplePoint(float uf, float vf, int inW, int inH) {
+
+    int ui = static_cast<int>(std::floor(uf));
+    int vi = static_cast<int>(std::floor(vf));
+
+    // Round the weights to 8 bits, rolling over to the next pixel when needed
+    int fu = static_cast<int>((uf - ui) * 256.0f + 0.5f);
+    int fv = static_cast<int>((vf - vi) * 256.0f + 0.5f);
+    if (fu > 255) {
+        fu = 0;
+        ++ui;
+    }
+    if (fv > 255) {
+        fv = 0;
+        ++vi;
+    }
+
+    // Columns wrap around the sphere, rows stop at the poles
+    ui %= inW;
+    if (ui < 0)
+        ui += inW;
+    vi = std::max(0, std::min(vi, inH - 1));
+
+    SamplePoint point;
+    point.u = static_cast<quint32>(ui);
+    point.v = static_cast<quint16>(vi);
+    point.fu = static_cast<quint8>(fu);
+    point.fv = static_cast<quint8>(fv);
+    return point;
+}
+
+// Locate the four source pixels of a sample point
+static inline void sampleTaps(const SourceView& source, const SamplePoint& point,
+                              quint32& a, quint32& b, quint32& c, quint32& d) {
+
+    const quint32 u2 = (point.u + 1 == static_cast<quint32>(source.width)) ? 0 : point.u + 1;
+    const int v2 = std::min(static_cast<int>(point.v) + 1, source.height - 1);
+
+    const quint32* top = reinterpret_cast<const quint32*>(source.bits + point.v * source.stride);
+    const quint32* bottom = reinterpret_cast<const quint32*>(source.bits + v2 * source.stride);
+
+    a = top[point.u];
+    b = top[u2];
+    c = bottom[point.u];
+    d = bottom[u2];
+}
+
+static inline QRgb blendTexel(quint32 a, quint32 b, quint32 c, quint32 d, int fu, int fv) {
+
+    const int ifu = 256 - fu;
+    const int ifv = 256 - fv;
+
+    QRgb result = 0xFF000000;
+    for (int shift = 0; shift < 24; shift += 8) {
+        const int left = (static_cast<int>((a >> shift) & 0xFF) * ifv + static_cast<int>((c >> shift) & 0xFF) * fv + 128) >> 8;
+        const int right = (static_cast<int>((b >> shift) & 0xFF) * ifv + static_cast<int>((d >> shift) & 0xFF) * fv + 128) >> 8;
+        result |= static_cast<QRgb>((left * ifu + right * fu + 128) >> 8) << shift;
+    }
+
+    return result;
+}
+
+static void sampleRowScalar(const SourceView& source, const SamplePoint* points, int count, QRgb* out) {
+
+    for (int i = 0; i < count; ++i) {
+        quint32 a, b, c, d;
+        sampleTaps(source, points[i], a, b, c, d);
+        out[i] = blendTexel(a, b, c, d, points[i].fu, points[i].fv);
+    }
+}
+
+// An RGB888 pixel as an RGB32 value, the alpha byte is left at zero
+static inline quint32 loadRGB888(const uchar* pixel) {
+    return (static_cast<quint32>(pixel[0]) << 16) | (static_cast<quint32>(pixel[1]) << 8) | pixel[2];
+}
+
+// Locate the four source pixels of a sample point in an RGB888 source
+static inline void sampleTaps24(const SourceView& source, const SamplePoint& point,
+                                quint32& a, quint32& b, quint32& c, quint32& d) {
+
+    const quint32 u2 = (point.u + 1 == static_cast<quint32>(source.width)) ? 0 : point.u + 1;
+    const int v2 = std::min(static_cast<int>(point.v) + 1, source.height - 1);
+
+    const uchar* top = source.bits + point.v * source.stride;
+    const uchar* bottom = source.bits + v2 * source.stride;
+
+    a = loadRGB888(top + point.u * 3);
+    b = loadRGB888(top + u2 * 3);
+    c = loadRGB888(bottom + point.u * 3);
+    d = loadRGB888(bottom + u2 * 3);
+}
+
+static void sampleRow24Scalar(const SourceView& source, const SamplePoint* points, int count, QRgb* out) {
+
+    for (int i = 0; i < count; ++i) {
+        quint32 a, b, c, d;
+        sampleTaps24(source, points[i], a, b, c, d);
+        out[i] = blendTexel(a, b, c, d, points[i].fu, points[i].fv);
+    }
+}
+
+// Locate the four source pixels of a sample point in an RGBA64 source
+static inline void sampleTaps64(const SourceView& source, const SamplePoint& point,
+                                quint64& a, quint64& b, quint64& c, quint64& d) {
+
+    const quint32 u2 = (point.u + 1 == static_cast<quint32>(source.width)) ? 0 : point.u + 1;
+    const int v2 = std::min(static_cast<int>(point.v) + 1, source.height - 1);
+
+    const quint64* top = reinterpret_cast<const quint64*>(source.bits + point.v * source.stride);
+    const quint64* bottom = reinterpret_cast<const quint64*>(source.bits + v2 * source.stride);
+
+    a = top[point.u];
+    b = top[u2];
+    c = bottom[point.u];
+    d = bottom[u2];
+}
+
+static inline quint64 blendTexel64(quint64 a, quint64 b, quint64 c, quint64 d, int fu, int fv) {
+
+    const quint32 ifu = 256 - fu;
+    const quint32 ifv = 256 - fv;
+
+    quint64 result = Q_UINT64_C(0xFFFF) << 48;
+    for (int shift = 0; shift < 48; shift += 16) {
+        const quint32 left = (static_cast<quint32>((a >> shift) & 0xFFFF) * ifv + static_cast<quint32>((c >> shift) & 0xFFFF) * fv + 128) >> 8;
+        const quint32 right = (static_cast<quint32>((b >> shift) & 0xFFFF) * ifv + static_cast<quint32>((d >> shift) & 0xFFFF) * fv + 128) >> 8;
+        result |= static_cast<quint64>((left * ifu + right * fu + 128) >> 8) << shift;
+    }
+
+    return result;
+}
+
+static void sampleRow64Scalar(const SourceView& source, const SamplePoint* points, int count, quint64* out) {
+
+    for (int i = 0; i < count; ++i) {
+        quint64 a, b, c, d;
+        sampleTaps64(source, points[i], a, b, c, d);
+        out[i] = blendTexel64(a, b, c, d, points[i].fu, points[i].fv);
+    }
+}
+
+#ifdef CUBEMAP_SAMPLER_X86
+
+// (x * wx + y * wy + 128) >> 8 on unsigned 16-bit lanes
+static inline __m128i lerp16(__m128i x, __m128i y, __m128i wx, __m128i wy) {
+
+    const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(x, wx), _mm_mullo_epi16(y, wy));
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+// Blend four pixels whose taps and weights are held in 32-bit lanes
+static inline __m128i blend4(__m128i a, __m128i b, __m128i c, __m128i d, __m128i fu, __m128i fv) {
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(256);
+
+    // Spread each pixel's weight over its four 16-bit channel lanes
+    fu = _mm_or_si128(fu, _mm_slli_epi32(fu, 16));
+    fv = _mm_or_si128(fv, _mm_slli_epi32(fv, 16));
+    const __m128i fu_lo = _mm_unpacklo_epi32(fu, fu);
+    const __m128i fu_hi = _mm_unpackhi_epi32(fu, fu);
+    const __m128i fv_lo = _mm_unpacklo_epi32(fv, fv);
+    const __m128i fv_hi = _mm_unpackhi_epi32(fv, fv);
+
+    const __m128i left_lo = lerp16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero), _mm_sub_epi16(full, fv_lo), fv_lo);
+    const __m128i left_hi = lerp16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero), _mm_sub_epi16(full, fv_hi), fv_hi);
+    const __m128i right_lo = lerp16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, fv_lo), fv_lo);
+    const __m128i right_hi = lerp16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, fv_hi), fv_hi);
+
+    const __m128i out_lo = lerp16(left_lo, right_lo, _mm_sub_epi16(full, fu_lo), fu_lo);
+    const __m128i out_hi = lerp16(left_hi, right_hi, _mm_sub_epi16(full, fu_hi), fu_hi);
+
+    return _mm_or_si128(_mm_packus_epi16(out_lo, out_hi), _mm_set1_epi32(static_cast<int>(0xFF000000)));
+}
+
+// SSE2 has no gather, so the taps are fetched one by one and blended four at a time
+static void sampleRowSSE2(const SourceView& source, const SamplePoint* points, int count, QRgb* out) {
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+
+        alignas(16) quint32 a[4], b[4], c[4], d[4], fu[4], fv[4];
+        for (int k = 0; k < 4; ++k) {
+            sampleTaps(source, points[i + k], a[k], b[k], c[k], d[k]);
+            fu[k] = points[i + k].fu;
+            fv[k] = points[i + k].fv;
+        }
+
+        const __m128i result = blend4(_mm_load_si128(reinterpret_cast<const __m128i*>(a)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(b)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(c)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(d)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(fu)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(fv)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+
+    sampleRowScalar(source, points + i, count - i, out + i);
+}
+
+// The same for RGB888 sources, the taps are widened to RGB32 as they are fetched
+static void sampleRow24SSE2(const SourceView& source, const SamplePoint* points, int count, QRgb* out) {
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+
+        alignas(16) quint32 a[4], b[4], c[4], d[4], fu[4], fv[4];
+        for (int k = 0; k < 4; ++k) {
+            sampleTaps24(source, points[i + k], a[k], b[k], c[k], d[k]);
+            fu[k] = points[i + k].fu;
+            fv[k] = points[i + k].fv;
+        }
+
+        const __m128i result = blend4(_mm_load_si128(reinterpret_cast<const __m128i*>(a)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(b)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(c)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(d)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(fu)),
+                                      _mm_load_si128(reinterpret_cast<const __m128i*>(fv)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+
+    sampleRow24Scalar(source, points + i, count - i, out + i);
+}
+
+//
+// 16-bit channel blending for the RGBA64 kernels
+//
+// madd only multiplies signed 16-bit values, so channels come in offset by
+// -32768 (the top bit flipped) and since the two weights always add up to 256,
+// the offset times 256 is added back along with the rounding term.
+//
+static inline __m128i lerp32(__m128i xy, __m128i weights) {
+    return _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(xy, weights), _mm_set1_epi32(32768 * 256 + 128)), 8);
+}
+
+// Blend two RGBA64 pixels, pixel 0 in the low and pixel 1 in the high half of each register
+static inline __m128i blend2x64(__m128i a, __m128i b, __m128i c, __m128i d,
+                                __m128i wu0, __m128i wu1, __m128i wv0, __m128i wv1) {
+
+    const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+    const __m128i offset = _mm_set1_epi32(32768);
+
+    a = _mm_xor_si128(a, flip);
+    b = _mm_xor_si128(b, flip);
+    c = _mm_xor_si128(c, flip);
+    d = _mm_xor_si128(d, flip);
+
+    const __m128i left0 = lerp32(_mm_unpacklo_epi16(a, c), wv0);
+    const __m128i left1 = lerp32(_mm_unpackhi_epi16(a, c), wv1);
+    const __m128i right0 = lerp32(_mm_unpacklo_epi16(b, d), wv0);
+    const __m128i right1 = lerp32(_mm_unpackhi_epi16(b, d), wv1);
+
+    // Back to offset 16-bit channels for the horizontal pass
+    const __m128i left = _mm_packs_epi32(_mm_sub_epi32(left0, offset), _mm_sub_epi32(left1, offset));
+    const __m128i right = _mm_packs_epi32(_mm_sub_epi32(right0, offset), _mm_sub_epi32(right1, offset));
+
+    const __m128i out0 = lerp32(_mm_unpacklo_epi16(left, right), wu0);
+    const __m128i out1 = lerp32(_mm_unpackhi_epi16(left, right), wu1);
+
+    const __m128i result = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(out0, offset), _mm_sub_epi32(out1, offset)), flip);
+    return _mm_or_si128(result, _mm_set1_epi64x(static_cast<long long>(Q_UINT64_C(0xFFFF000000000000))));
+}
+
+// A pair of 16-bit weights (256 - f, f) for madd
+static inline __m128i weightPair(int f) {
+    return _mm_set1_epi32(((f << 16) | (256 - f)));
+}
+
+static void sampleRow64SSE2(const SourceView& source, const SamplePoint* points, int count, quint64* out) {
+
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+
+        alignas(16) quint64 a[2], b[2], c[2], d[2];
+        sampleTaps64(source, points[i], a[0], b[0], c[0], d[0]);
+        sampleTaps64(source, points[i + 1], a[1], b[1], c[1], d[1]);
+
+        const __m128i result = blend2x64(_mm_load_si128(reinterpret_cast<const __m128i*>(a)),
+                                         _mm_load_si128(reinterpret_cast<const __m128i*>(b)),
+                                         _mm_load_si128(reinterpret_cast<const __m128i*>(c)),
+                                         _mm_load_si128(reinterpret_cast<const __m128i*>(d)),
+                                         weightPair(points[i].fu), weightPair(points[i + 1].fu),
+                                         weightPair(points[i].fv), weightPair(points[i + 1].fv));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+
+    sampleRow64Scalar(source, points + i, count - i, out + i);
+}
+
+#define CUBEMAP_AVX2 __attribute__((target("avx2")))
+
+CUBEMAP_AVX2 static inline __m256i lerp16x16(__m256i x, __m256i y, __m256i wx, __m256i wy) {
+
+    const __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(x, wx), _mm256_mullo_epi16(y, wy));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(128)), 8);
+}
+
+// Split eight 8-byte sample points into u, v, fu and fv lanes
+CUBEMAP_AVX2 static inline void splitPoints8(const SamplePoint* points, __m256i& u, __m256i& v, __m256i& fu, __m256i& fv) {
+
+    const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i p0 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(points)), split);
+    const __m256i p1 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(points + 4)), split);
+    u = _mm256_permute2x128_si256(p0, p1, 0x20);
+    const __m256i packed = _mm256_permute2x128_si256(p0, p1, 0x31);
+
+    v = _mm256_and_si256(packed, _mm256_set1_epi32(0xFFFF));
+    fu = _mm256_and_si256(_mm256_srli_epi32(packed, 16), _mm256_set1_epi32(0xFF));
+    fv = _mm256_srli_epi32(packed, 24);
+}
+
+// Blend eight RGB32 pixels from their gathered taps
+CUBEMAP_AVX2 static inline __m256i blend8(__m256i a, __m256i b, __m256i c, __m256i d, __m256i fu, __m256i fv) {
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi16(256);
+
+    // Spread each pixel's weight over its four 16-bit channel lanes
+    const __m256i fu16 = _mm256_or_si256(fu, _mm256_slli_epi32(fu, 16));
+    const __m256i fv16 = _mm256_or_si256(fv, _mm256_slli_epi32(fv, 16));
+    const __m256i fu_lo = _mm256_unpacklo_epi32(fu16, fu16);
+    const __m256i fu_hi = _mm256_unpackhi_epi32(fu16, fu16);
+    const __m256i fv_lo = _mm256_unpacklo_epi32(fv16, fv16);
+    const __m256i fv_hi = _mm256_unpackhi_epi32(fv16, fv16);
+
+    const __m256i left_lo = lerp16x16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(c, zero), _mm256_sub_epi16(full, fv_lo), fv_lo);
+    const __m256i left_hi = lerp16x16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(c, zero), _mm256_sub_epi16(full, fv_hi), fv_hi);
+    const __m256i right_lo = lerp16x16(_mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, fv_lo), fv_lo);
+    const __m256i right_hi = lerp16x16(_mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, fv_hi), fv_hi);
+
+    const __m256i out_lo = lerp16x16(left_lo, right_lo, _mm256_sub_epi16(full, fu_lo), fu_lo);
+    const __m256i out_hi = lerp16x16(left_hi, right_hi, _mm256_sub_epi16(full, fu_hi), fu_hi);
+
+    // The unpacks and the pack both work per 128-bit lane, so pixel order is kept
+    return _mm256_or_si256(_mm256_packus_epi16(out_lo, out_hi), _mm256_set1_epi32(static_cast<int>(0xFF000000)));
+}
+
+// AVX2 gathers the four taps of eight pixels at once and blends them in 16-bit lanes
+CUBEMAP_AVX2 static void sampleRowAVX2(const SourceView& source, const SamplePoint* points, int count, QRgb* out) {
+
+    // Gather indices are signed 32-bit pixel offsets, so huge sources use SSE2
+    const qsizetype stride_pixels = source.stride / 4;
+    if (stride_pixels * source.height > 0x7FFFFFFF || source.stride % 4 != 0) {
+        sampleRowSSE2(source, points, count, out);
+        return;
+    }
+
+    const int* base = reinterpret_cast<const int*>(source.bits);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i width = _mm256_set1_epi32(source.width);
+    const __m256i last_row = _mm256_set1_epi32(source.height - 1);
+    const __m256i stride = _mm256_set1_epi32(static_cast<int>(stride_pixels));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+
+        __m256i u, v, fu, fv;
+        splitPoints8(points + i, u, v, fu, fv);
+
+        // Right column wraps, bottom row clamps
+        __m256i u2 = _mm256_add_epi32(u, one);
+        u2 = _mm256_andnot_si256(_mm256_cmpeq_epi32(u2, width), u2);
+        const __m256i v2 = _mm256_min_epi32(_mm256_add_epi32(v, one), last_row);
+
+        const __m256i top = _mm256_mullo_epi32(v, stride);
+        const __m256i bottom = _mm256_mullo_epi32(v2, stride);
+
+        const __m256i a = _mm256_i32gather_epi32(base, _mm256_add_epi32(top, u), 4);
+        const __m256i b = _mm256_i32gather_epi32(base, _mm256_add_epi32(top, u2), 4);
+        const __m256i c = _mm256_i32gather_epi32(base, _mm256_add_epi32(bottom, u), 4);
+        const __m256i d = _mm256_i32gather_epi32(base, _mm256_add_epi32(bottom, u2), 4);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), blend8(a, b, c, d, fu, fv));
+    }
+
+    sampleRowScalar(source, points + i, count - i, out + i);
+}
+
+//
+// RGB888 sources are gathered as 4-byte words at byte offsets and shuffled into
+// RGB32 order.  Each word reads one byte past its pixel, which only leaves the
+// image for the very last pixel, so the odd batch of eight that touches it is
+// done by the scalar kernel instead.
+//
+CUBEMAP_AVX2 static void sampleRow24AVX2(const SourceView& source, const SamplePoint* points, int count, QRgb* out) {
+
+    if (source.stride * source.height > 0x7FFFFFFF) {
+        sampleRow24SSE2(source, points, count, out);
+        return;
+    }
+
+    const int* base = reinterpret_cast<const int*>(source.bits);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i width = _mm256_set1_epi32(source.width);
+    const __m256i last_column = _mm256_set1_epi32(source.width - 1);
+    const __m256i last_row = _mm256_set1_epi32(source.height - 1);
+    const __m256i stride = _mm256_set1_epi32(static_cast<int>(source.stride));
+    const __m256i to_rgb32 = _mm256_setr_epi8(2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128,
+                                              2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+
+        __m256i u, v, fu, fv;
+        splitPoints8(points + i, u, v, fu, fv);
+
+        // Right column wraps, bottom row clamps
+        __m256i u2 = _mm256_add_epi32(u, one);
+        u2 = _mm256_andnot_si256(_mm256_cmpeq_epi32(u2, width), u2);
+        const __m256i v2 = _mm256_min_epi32(_mm256_add_epi32(v, one), last_row);
+
+        // Any tap on the last pixel of the last row?
+        const __m256i last_tap = _mm256_and_si256(_mm256_cmpeq_epi32(v2, last_row),
+                                                  _mm256_or_si256(_mm256_cmpeq_epi32(u, last_column), _mm256_cmpeq_epi32(u2, last_column)));
+        if (_mm256_movemask_epi8(last_tap)) {
+            sampleRow24Scalar(source, points + i, 8, out + i);
+            continue;
+        }
+
+        const __m256i top = _mm256_mullo_epi32(v, stride);
+        const __m256i bottom = _mm256_mullo_epi32(v2, stride);
+        const __m256i left = _mm256_mullo_epi32(u, three);
+        const __m256i right = _mm256_mullo_epi32(u2, three);
+
+        const __m256i a = _mm256_shuffle_epi8(_mm256_i32gather_epi32(base, _mm256_add_epi32(top, left), 1), to_rgb32);
+        const __m256i b = _mm256_shuffle_epi8(_mm256_i32gather_epi32(base, _mm256_add_epi32(top, right), 1), to_rgb32);
+        const __m256i c = _mm256_shuffle_epi8(_mm256_i32gather_epi32(base, _mm256_add_epi32(bottom, left), 1), to_rgb32);
+        const __m256i d = _mm256_shuffle_epi8(_mm256_i32gather_epi32(base, _mm256_add_epi32(bottom, right), 1), to_rgb32);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), blend8(a, b, c, d, fu, fv));
+    }
+
+    sampleRow24Scalar(source, points + i, count - i, out + i);
+}
+
+CUBEMAP_AVX2 static inline __m256i lerp32x8(__m256i xy, __m256i weights) {
+    return _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(xy, weights), _mm256_set1_epi32(32768 * 256 + 128)), 8);
+}
+
+// AVX2 gathers the taps of four RGBA64 pixels at once, the blend is blend2x64() on both 128-bit lanes
+CUBEMAP_AVX2 static void sampleRow64AVX2(const SourceView& source, const SamplePoint* points, int count, quint64* out) {
+
+    const qsizetype stride_pixels = source.stride / 8;
+    if (stride_pixels * source.height > 0x7FFFFFFF || source.stride % 8 != 0) {
+        sampleRow64SSE2(source, points, count, out);
+        return;
+    }
+
+    const long long* base = reinterpret_cast<const long long*>(source.bits);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i full = _mm_set1_epi32(256);
+    const __m128i width = _mm_set1_epi32(source.width);
+    const __m128i last_row = _mm_set1_epi32(source.height - 1);
+    const __m128i stride = _mm_set1_epi32(static_cast<int>(stride_pixels));
+    const __m128i low_word = _mm_set1_epi32(0xFFFF);
+    const __m128i low_byte = _mm_set1_epi32(0xFF);
+    const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i even = _mm256_setr_epi32(0, 0, 0, 0, 2, 2, 2, 2);
+    const __m256i odd = _mm256_setr_epi32(1, 1, 1, 1, 3, 3, 3, 3);
+    const __m256i flip = _mm256_set1_epi16(static_cast<short>(0x8000));
+    const __m256i offset = _mm256_set1_epi32(32768);
+    const __m256i opaque = _mm256_set1_epi64x(static_cast<long long>(Q_UINT64_C(0xFFFF000000000000)));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+
+        // Split four 8-byte sample points into u and (v, fu, fv) lanes
+        const __m256i p = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(points + i)), split);
+        const __m128i u = _mm256_castsi256_si128(p);
+        const __m128i packed = _mm256_extracti128_si256(p, 1);
+
+        const __m128i v = _mm_and_si128(packed, low_word);
+        const __m128i fu = _mm_and_si128(_mm_srli_epi32(packed, 16), low_byte);
+        const __m128i fv = _mm_srli_epi32(packed, 24);
+
+        // Right column wraps, bottom row clamps
+        __m128i u2 = _mm_add_epi32(u, one);
+        u2 = _mm_andnot_si128(_mm_cmpeq_epi32(u2, width), u2);
+        const __m128i v2 = _mm_min_epi32(_mm_add_epi32(v, one), last_row);
+
+        const __m128i top = _mm_mullo_epi32(v, stride);
+        const __m128i bottom = _mm_mullo_epi32(v2, stride);
+
+        __m256i a = _mm256_i32gather_epi64(base, _mm_add_epi32(top, u), 8);
+        __m256i b = _mm256_i32gather_epi64(base, _mm_add_epi32(top, u2), 8);
+        __m256i c = _mm256_i32gather_epi64(base, _mm_add_epi32(bottom, u), 8);
+        __m256i d = _mm256_i32gather_epi64(base, _mm_add_epi32(bottom, u2), 8);
+
+        // (256 - f, f) weight pairs, pixels 0 and 2 go with the low unpacks, 1 and 3 with the high ones
+        const __m256i wu = _mm256_castsi128_si256(_mm_or_si128(_mm_sub_epi32(full, fu), _mm_slli_epi32(fu, 16)));
+        const __m256i wv = _mm256_castsi128_si256(_mm_or_si128(_mm_sub_epi32(full, fv), _mm_slli_epi32(fv, 16)));
+        const __m256i wu_lo = _mm256_permutevar8x32_epi32(wu, even);
+        const __m256i wu_hi = _mm256_permutevar8x32_epi32(wu, odd);
+        const __m256i wv_lo = _mm256_permutevar8x32_epi32(wv, even);
+        const __m256i wv_hi = _mm256_permutevar8x32_epi32(wv, odd);
+
+        a = _mm256_xor_si256(a, flip);
+        b = _mm256_xor_si256(b, flip);
+        c = _mm256_xor_si256(c, flip);
+        d = _mm256_xor_si256(d, flip);
+
+        const __m256i left_lo = lerp32x8(_mm256_unpacklo_epi16(a, c), wv_lo);
+        const __m256i left_hi = lerp32x8(_mm256_unpackhi_epi16(a, c), wv_hi);
+        const __m256i right_lo = lerp32x8(_mm256_unpacklo_epi16(b, d), wv_lo);
+        const __m256i right_hi = lerp32x8(_mm256_unpackhi_epi16(b, d), wv_hi);
+
+        const __m256i left = _mm256_packs_epi32(_mm256_sub_epi32(left_lo, offset), _mm256_sub_epi32(left_hi, offset));
+        const __m256i right = _mm256_packs_epi32(_mm256_sub_epi32(right_lo, offset), _mm256_sub_epi32(right_hi, offset));
+
+        const __m256i out_lo = lerp32x8(_mm256_unpacklo_epi16(left, right), wu_lo);
+        const __m256i out_hi = lerp32x8(_mm256_unpackhi_epi16(left, right), wu_hi);
+
+        // The unpacks and the pack both work per 128-bit lane, so pixel order is kept
+        const __m256i result = _mm256_xor_si256(_mm256_packs_epi32(_mm256_sub_epi32(out_lo, offset), _mm256_sub_epi32(out_hi, offset)), flip);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_or_si256(result, opaque));
+    }
+
+    sampleRow64Scalar(source, points + i, count - i, out + i);
+}
+
+#endif // CUBEMAP_SAMPLER_X86
+
+SampleKernel resolveSampleKernel(SampleKernel requested) {
+
+#ifdef CUBEMAP_SAMPLER_X86
+    __builtin_cpu_init();
+    const bool has_avx2 = __builtin_cpu_supports("avx2");
+    const bool has_sse2 = __builtin_cpu_supports("sse2");
+#else
+    const bool has_avx2 = false;
+    const bool has_sse2 = false;
+#endif
+
+    // Fall back one level at a time when the CPU can't run what was asked for
+    if (requested == SampleKernel::Auto || requested == SampleKernel::AVX2)
+        requested = has_avx2 ? SampleKernel::AVX2 : SampleKernel::SSE2;
+    if (requested == SampleKernel::SSE2 && !has_sse2)
+        requested = SampleKernel::Scalar;
+
+    return requested;
+}
+
+SampleRowFunction sampleRowFunction(SampleKernel kernel) {
+
+    switch (resolveSampleKernel(kernel)) {
+#ifdef CUBEMAP_SAMPLER_X86
+        case SampleKernel::AVX2: return sampleRowAVX2;
+        case SampleKernel::SSE2: return sampleRowSSE2;
+#endif
+        default: return sampleRowScalar;
+    }
+}
+
+SampleRowFunction sampleRow24Function(SampleKernel kernel) {
+
+    switch (resolveSampleKernel(kernel)) {
+#ifdef CUBEMAP_SAMPLER_X86
+        case SampleKernel::AVX2: return sampleRow24AVX2;
+        case SampleKernel::SSE2: return sampleRow24SSE2;
+#endif
+        default: return sampleRow24Scalar;
+    }
+}
+
+SampleRow64Function sampleRow64Function(SampleKernel kernel) {
+
+    switch (resolveSampleKernel(kernel)) {
+#ifdef CUBEMAP_SAMPLER_X86
+        case SampleKernel::AVX2: return sampleRow64AVX2;
+        case SampleKernel::SSE2: return sampleRow64SSE2;
+#endif
+        default: return sampleRow64Scalar;
+    }
+}
+
+const char* sampleKernelName(SampleKernel kernel) {
+
+    switch (kernel) {
+        case SampleKernel::Auto: return "auto";
+        case SampleKernel::Scalar: return "scalar";
+        case SampleKernel::SSE2: return "sse2";
+        case SampleKernel::AVX2: return "avx2";
+    }
+
+    return "unknown";
+}
+
+QImage makeSourceImage(const QImage& image) {
+
+    // The kernels read 32-bit pixels, the alpha channel is ignored
+    if (image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32)
+        return image;
+
+    return image.convertToFormat(QImage::Format_RGB32);
+}
+
+SourceView makeSourceView(const QImage& source) {
+
+    SourceView view;
+    view.bits = source.constBits();
+    view.stride = source.bytesPerLine();
+    view.width = source.width();
+    view.height = source.height();
+    return view;
+}
+
+QImage makeSourceImage64(const QImage& image) {
+
+    // The 64-bit kernels read 16-bit R, G, B, A channels, the alpha channel is ignored
+    if (image.format() == QImage::Format_RGBA64 || image.format() == QImage::Format_RGBX64)
+        return image;
+
+    return image.convertToFormat(QImage::Format_RGBA64);
+}
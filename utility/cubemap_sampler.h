@@ -0,0 +1,88 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef CUBEMAP_SAMPLER_HPP
+#define CUBEMAP_SAMPLER_HPP
+
+// Qt includes
+#include <QtGlobal>
+#include <QImage>
+
+//
+// Where one output texel reads the equirectangular source
+//
+// u and v are the top-left of the 2x2 bilinear footprint, fu and fv are the
+// 8-bit fixed-point weights of the right column and bottom row (0..255).
+// The right column wraps around to column 0, the bottom row is clamped.
+//
+struct SamplePoint {
+    quint32 u;
+    quint16 v;
+    quint8  fu;
+    quint8  fv;
+};
+
+// Raw view of a 24-bit (RGB888), 32-bit (RGB32/ARGB32) or 64-bit (RGBA64/RGBX64) source image
+struct SourceView {
+    const uchar *bits;
+    qsizetype    stride;
+    int          width;
+    int          height;
+};
+
+// Blend count output pixels from the source, one SamplePoint per pixel
+typedef void (*SampleRowFunction)(const SourceView& source, const SamplePoint* points, int count, QRgb* out);
+
+// The same for 16 bits per channel RGBA64 sources and output pixels
+typedef void (*SampleRow64Function)(const SourceView& source, const SamplePoint* points, int count, quint64* out);
+
+// Instruction sets the sampling kernel can be built for
+enum class SampleKernel {
+    Auto,
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// SamplePoint keeps its row in 16 bits, so sources can be at most this many rows tall
+const int SAMPLE_MAX_SOURCE_HEIGHT = 65536;
+
+// Turn a floating point source position into a SamplePoint
+SamplePoint makeSamplePoint(float uf, float vf, int inW, int inH);
+
+// Pick the sampling kernel, Auto chooses the best one this CPU supports
+SampleKernel resolveSampleKernel(SampleKernel requested);
+SampleRowFunction sampleRowFunction(SampleKernel kernel);
+SampleRowFunction sampleRow24Function(SampleKernel kernel);
+SampleRow64Function sampleRow64Function(SampleKernel kernel);
+const char* sampleKernelName(SampleKernel kernel);
+
+// Wrap a 32-bit image as a SourceView, converting it first if need be
+QImage makeSourceImage(const QImage& image);
+SourceView makeSourceView(const QImage& source);
+
+// Make a 64-bit RGBA64 copy of an image for the 16 bits per channel kernels, unless it already is one
+QImage makeSourceImage64(const QImage& image);
+
+#endif // CUBEMAP_SAMPLER_HPP
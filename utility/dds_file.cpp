@@ -0,0 +1,80 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <iostream>
+
+// Positioned writes
+#include <unistd.h>
+
+#include "dds_file.h"
+
+DDSFile::~DDSFile() {
+    close();
+}
+
+bool DDSFile::open(const QString& path, qint64 bytes, bool keep_contents) {
+
+    close();
+    m_failed = false;
+    m_file.setFileName(path);
+
+    // Updating a DDS keeps every byte that isn't written again
+    const bool opened = keep_contents ? m_file.open(QIODevice::ReadWrite)
+                                      : m_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!opened || !m_file.resize(bytes)) {
+        std::cerr << "Could not open file for writing: " << path.toStdString() << std::endl;
+        m_file.close();
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool DDSFile::write(qint64 offset, const void* data, qint64 bytes) {
+
+    const int fd = m_file.handle();
+    const char* src = static_cast<const char*>(data);
+
+    // pwrite() may write less than asked for, carry on from where it stopped
+    while (bytes > 0 && fd >= 0) {
+        const ssize_t written = ::pwrite(fd, src, static_cast<size_t>(bytes), static_cast<off_t>(offset));
+        if (written <= 0)
+            break;
+        src += written;
+        offset += written;
+        bytes -= written;
+    }
+
+    if (bytes > 0)
+        m_failed = true;
+    return bytes == 0;
+}
+
+bool DDSFile::close(void) {
+
+    if (m_file.isOpen())
+        m_file.close();
+    return !m_failed;
+}
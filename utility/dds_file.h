@@ -0,0 +1,70 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef DDS_FILE_HPP
+#define DDS_FILE_HPP
+
+// C++ and STL includes
+#include <atomic>
+
+// Qt includes
+#include <QFile>
+#include <QString>
+
+//
+// An output file sized up front and written at explicit offsets
+//
+// Every face and mip level of a DDS has a fixed place once the header is
+// known, so the file is created at its final size and each region is written
+// with pwrite().  Nothing is shared between writes, so threads can fill
+// different faces at the same time instead of taking turns on one stream.
+// The file isn't memory-mapped, written pages would then count against the
+// resident memory the converter reports and budgets for.
+//
+class DDSFile {
+
+public:
+
+    DDSFile() = default;
+    ~DDSFile();
+
+    DDSFile(const DDSFile&) = delete;
+    DDSFile& operator=(const DDSFile&) = delete;
+
+    // Create the file at path with a size of bytes, or open it as it is to update part of it
+    bool open(const QString& path, qint64 bytes, bool keep_contents = false);
+
+    // Write bytes at offset, safe to call from several threads for regions that don't overlap
+    bool write(qint64 offset, const void* data, qint64 bytes);
+
+    // Close the file, false if it couldn't be opened or any write failed
+    bool close(void);
+
+private:
+
+    QFile               m_file;
+    std::atomic<bool>   m_failed{ false };
+};
+
+#endif // DDS_FILE_HPP
@@ -0,0 +1,118 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// Qt includes
+#include <QByteArrayView>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "image_to_cubemap.h"
+#include "face_hashes.h"
+
+// First line of a sidecar, a new layout gets a new version
+static const char* FACE_HASHES_HEADER = "image_to_cubemap face hashes 1";
+
+static QString faceHashesPath(const QString& dds_path) {
+    return dds_path + ".faces";
+}
+
+void hashCubemapFaces(const FaceViews& faces, ThreadPool& pool, FaceHashes& hashes) {
+
+    const qsizetype row_bytes = static_cast<qsizetype>(faces.edge) * (faces.depth / 8);
+
+    // SHA-1 only has to notice edits here, the rows of unfolded faces aren't contiguous so they're added one by one
+    pool.parallelFor(6, [&](int face) {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        for (int row = 0; row < faces.edge; ++row)
+            hash.addData(QByteArrayView(reinterpret_cast<const char*>(faces.bits[face] + row * faces.stride), row_bytes));
+        hashes.faces[face] = hash.result();
+    });
+}
+
+//
+// Read a sidecar, it's a header line, the settings, the DDS size and time, then one hex hash per face
+//
+static bool loadFaceHashes(const QString& path, FaceHashes& hashes) {
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    if (lines.size() < 9 || lines[0] != FACE_HASHES_HEADER)
+        return false;
+
+    hashes.settings = QString::fromUtf8(lines[1]);
+
+    bool bytes_ok = false;
+    bool modified_ok = false;
+    hashes.dds_bytes = lines[2].toLongLong(&bytes_ok);
+    hashes.dds_modified = lines[3].toLongLong(&modified_ok);
+    if (!bytes_ok || !modified_ok)
+        return false;
+
+    for (int face = 0; face < 6; ++face)
+        hashes.faces[face] = QByteArray::fromHex(lines[4 + face]);
+    return true;
+}
+
+int staleCubemapFaces(const QString& dds_path, const FaceHashes& current) {
+
+    FaceHashes previous;
+    if (!loadFaceHashes(faceHashesPath(dds_path), previous) || previous.settings != current.settings)
+        return CUBEMAP_ALL_FACES;
+
+    // Anything else that wrote the DDS since leaves the sidecar describing other faces
+    const QFileInfo dds_info(dds_path);
+    if (!dds_info.exists() || dds_info.size() != previous.dds_bytes ||
+        dds_info.lastModified().toMSecsSinceEpoch() != previous.dds_modified)
+        return CUBEMAP_ALL_FACES;
+
+    int face_mask = 0;
+    for (int face = 0; face < 6; ++face)
+        if (previous.faces[face].isEmpty() || previous.faces[face] != current.faces[face])
+            face_mask |= 1 << face;
+    return face_mask;
+}
+
+bool saveFaceHashes(const QString& dds_path, FaceHashes& current) {
+
+    const QFileInfo dds_info(dds_path);
+    current.dds_bytes = dds_info.size();
+    current.dds_modified = dds_info.lastModified().toMSecsSinceEpoch();
+
+    QByteArray text = QByteArray(FACE_HASHES_HEADER) + '\n' + current.settings.toUtf8() + '\n' +
+                      QByteArray::number(current.dds_bytes) + '\n' + QByteArray::number(current.dds_modified) + '\n';
+    for (int face = 0; face < 6; ++face)
+        text += current.faces[face].toHex() + '\n';
+
+    // Like the remap cache, the sidecar is only replaced once it's completely written
+    QSaveFile file(faceHashesPath(dds_path));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(text);
+    return file.commit();
+}
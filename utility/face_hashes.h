@@ -0,0 +1,62 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef FACE_HASHES_HPP
+#define FACE_HASHES_HPP
+
+// Qt includes
+#include <QByteArray>
+#include <QString>
+
+#include "thread_pool.h"
+#include "cubemap_convert.h"
+
+//
+// Hashes of the full size faces of a cubemap, kept next to its DDS
+//
+// The sidecar (<dds>.faces) lets an edited unfolded cubemap be written again
+// face by face: only faces whose hash changed are rebuilt and rewritten.  It
+// also records the settings the DDS was written with and the size and time of
+// the file, so a DDS written with other settings, or by anything else since,
+// is always written in full.
+//
+struct FaceHashes {
+    QString     settings;
+    QByteArray  faces[6];
+    qint64      dds_bytes = 0;
+    qint64      dds_modified = 0;   // Milliseconds since the epoch
+};
+
+// Hash the pixels of each face, one face per task
+void hashCubemapFaces(const FaceViews& faces, ThreadPool& pool, FaceHashes& hashes);
+
+// Faces of the DDS at dds_path that have to be written for the current hashes, bit f
+// set for face f: the faces that changed, or all of them when the sidecar is missing,
+// was written with other settings or the DDS doesn't match it any more
+int staleCubemapFaces(const QString& dds_path, const FaceHashes& current);
+
+// Save the current hashes along with the size and time of the DDS just written
+bool saveFaceHashes(const QString& dds_path, FaceHashes& current);
+
+#endif // FACE_HASHES_HPP
@@ -0,0 +1,210 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// x86 SIMD intrinsics, other CPUs use the scalar row function
+#if defined(__x86_64__) || defined(__i386__)
+#define FAST_MATH_X86 1
+#include <immintrin.h>
+#endif
+
+#include "fast_math.h"
+
+//
+// Every row function works out a position as the exact multiple of a quarter
+// (or half) of the source size for the whole quarter turns, plus the
+// polynomial's part scaled by pixels per radian:
+//
+//   uf = (inW / 2 + quarter_turns_u * inW / 4) + offset_u * inW / (2 * pi)
+//   vf = (inH / 2 - quarter_turns_v * inH / 2) - offset_v * inH / pi
+//
+// in that order, so all of them round the same way.
+//
+
+// The plain C++ version, also used for the last few directions of a row
+static void sphericalRowScalar(const float* x, const float* y, const float* z, int count,
+                               int inW, int inH, float* uf, float* vf) {
+
+    const float half_w = 0.5f * inW;
+    const float quarter_w = 0.25f * inW;
+    const float half_h = 0.5f * inH;
+    const float u_scale = static_cast<float>(inW / (2 * M_PI));
+    const float v_scale = static_cast<float>(inH / M_PI);
+
+    for (int i = 0; i < count; ++i) {
+
+        float quarter_turns, offset;
+        fastAtan2Split(x[i], z[i], quarter_turns, offset);
+        uf[i] = (half_w + quarter_turns * quarter_w) + offset * u_scale;
+
+        fastAtan2Split(y[i], fastHypot(x[i], z[i]), quarter_turns, offset);
+        vf[i] = (half_h - quarter_turns * half_h) - offset * v_scale;
+    }
+}
+
+#ifdef FAST_MATH_X86
+
+// SSE2 has no blend, so lanes are picked with masks
+static inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// fastAtan() and fastAtan2Split() on four lanes
+static inline __m128 atan4(__m128 t) {
+
+    const __m128 t2 = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(0.0028662257f);
+    p = _mm_sub_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.0161657367f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.0429096138f));
+    p = _mm_sub_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.0752896400f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.1065626393f));
+    p = _mm_sub_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.1420889944f));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.1999355085f));
+    p = _mm_sub_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.3333314528f));
+    return _mm_add_ps(t, _mm_mul_ps(t, _mm_mul_ps(t2, p)));
+}
+
+static inline void atan2Split4(__m128 y, __m128 x, __m128& quarter_turns, __m128& offset) {
+
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 ax = _mm_andnot_ps(sign, x);
+    const __m128 ay = _mm_andnot_ps(sign, y);
+    const __m128 a = atan4(_mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(FLT_MIN))));
+
+    const __m128 steep = _mm_cmpgt_ps(ay, ax);
+    quarter_turns = _mm_and_ps(steep, _mm_set1_ps(1.0f));
+    offset = _mm_xor_ps(a, _mm_and_ps(steep, sign));
+
+    const __m128 left = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+    quarter_turns = select4(left, _mm_sub_ps(_mm_set1_ps(2.0f), quarter_turns), quarter_turns);
+    offset = _mm_xor_ps(offset, _mm_and_ps(left, sign));
+
+    const __m128 down = _mm_and_ps(y, sign);
+    quarter_turns = _mm_xor_ps(quarter_turns, down);
+    offset = _mm_xor_ps(offset, down);
+}
+
+static void sphericalRowSSE2(const float* x, const float* y, const float* z, int count,
+                             int inW, int inH, float* uf, float* vf) {
+
+    const __m128 half_w = _mm_set1_ps(0.5f * inW);
+    const __m128 quarter_w = _mm_set1_ps(0.25f * inW);
+    const __m128 half_h = _mm_set1_ps(0.5f * inH);
+    const __m128 u_scale = _mm_set1_ps(static_cast<float>(inW / (2 * M_PI)));
+    const __m128 v_scale = _mm_set1_ps(static_cast<float>(inH / M_PI));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+
+        const __m128 xs = _mm_loadu_ps(x + i);
+        const __m128 ys = _mm_loadu_ps(y + i);
+        const __m128 zs = _mm_loadu_ps(z + i);
+        __m128 quarter_turns, offset;
+
+        atan2Split4(xs, zs, quarter_turns, offset);
+        _mm_storeu_ps(uf + i, _mm_add_ps(_mm_add_ps(half_w, _mm_mul_ps(quarter_turns, quarter_w)), _mm_mul_ps(offset, u_scale)));
+
+        const __m128 hypot = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(xs, xs), _mm_mul_ps(zs, zs)));
+        atan2Split4(ys, hypot, quarter_turns, offset);
+        _mm_storeu_ps(vf + i, _mm_sub_ps(_mm_sub_ps(half_h, _mm_mul_ps(quarter_turns, half_h)), _mm_mul_ps(offset, v_scale)));
+    }
+
+    sphericalRowScalar(x + i, y + i, z + i, count - i, inW, inH, uf + i, vf + i);
+}
+
+#define FAST_MATH_AVX2 __attribute__((target("avx2")))
+
+// The same on eight lanes, AVX has a real blend on the sign bit of the mask
+FAST_MATH_AVX2 static inline __m256 atan8(__m256 t) {
+
+    const __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 p = _mm256_set1_ps(0.0028662257f);
+    p = _mm256_sub_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(0.0161657367f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(0.0429096138f));
+    p = _mm256_sub_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(0.0752896400f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(0.1065626393f));
+    p = _mm256_sub_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(0.1420889944f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(0.1999355085f));
+    p = _mm256_sub_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(0.3333314528f));
+    return _mm256_add_ps(t, _mm256_mul_ps(t, _mm256_mul_ps(t2, p)));
+}
+
+FAST_MATH_AVX2 static inline void atan2Split8(__m256 y, __m256 x, __m256& quarter_turns, __m256& offset) {
+
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 ax = _mm256_andnot_ps(sign, x);
+    const __m256 ay = _mm256_andnot_ps(sign, y);
+    const __m256 a = atan8(_mm256_div_ps(_mm256_min_ps(ax, ay), _mm256_max_ps(_mm256_max_ps(ax, ay), _mm256_set1_ps(FLT_MIN))));
+
+    const __m256 steep = _mm256_cmp_ps(ay, ax, _CMP_GT_OQ);
+    quarter_turns = _mm256_and_ps(steep, _mm256_set1_ps(1.0f));
+    offset = _mm256_xor_ps(a, _mm256_and_ps(steep, sign));
+
+    quarter_turns = _mm256_blendv_ps(quarter_turns, _mm256_sub_ps(_mm256_set1_ps(2.0f), quarter_turns), x);
+    offset = _mm256_xor_ps(offset, _mm256_and_ps(x, sign));
+
+    const __m256 down = _mm256_and_ps(y, sign);
+    quarter_turns = _mm256_xor_ps(quarter_turns, down);
+    offset = _mm256_xor_ps(offset, down);
+}
+
+FAST_MATH_AVX2 static void sphericalRowAVX2(const float* x, const float* y, const float* z, int count,
+                                            int inW, int inH, float* uf, float* vf) {
+
+    const __m256 half_w = _mm256_set1_ps(0.5f * inW);
+    const __m256 quarter_w = _mm256_set1_ps(0.25f * inW);
+    const __m256 half_h = _mm256_set1_ps(0.5f * inH);
+    const __m256 u_scale = _mm256_set1_ps(static_cast<float>(inW / (2 * M_PI)));
+    const __m256 v_scale = _mm256_set1_ps(static_cast<float>(inH / M_PI));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+
+        const __m256 xs = _mm256_loadu_ps(x + i);
+        const __m256 ys = _mm256_loadu_ps(y + i);
+        const __m256 zs = _mm256_loadu_ps(z + i);
+        __m256 quarter_turns, offset;
+
+        atan2Split8(xs, zs, quarter_turns, offset);
+        _mm256_storeu_ps(uf + i, _mm256_add_ps(_mm256_add_ps(half_w, _mm256_mul_ps(quarter_turns, quarter_w)), _mm256_mul_ps(offset, u_scale)));
+
+        const __m256 hypot = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(xs, xs), _mm256_mul_ps(zs, zs)));
+        atan2Split8(ys, hypot, quarter_turns, offset);
+        _mm256_storeu_ps(vf + i, _mm256_sub_ps(_mm256_sub_ps(half_h, _mm256_mul_ps(quarter_turns, half_h)), _mm256_mul_ps(offset, v_scale)));
+    }
+
+    sphericalRowSSE2(x + i, y + i, z + i, count - i, inW, inH, uf + i, vf + i);
+}
+
+#endif // FAST_MATH_X86
+
+SphericalRowFunction sphericalRowFunction(SampleKernel kernel) {
+
+    switch (resolveSampleKernel(kernel)) {
+#ifdef FAST_MATH_X86
+        case SampleKernel::AVX2: return sphericalRowAVX2;
+        case SampleKernel::SSE2: return sphericalRowSSE2;
+#endif
+        default: return sphericalRowScalar;
+    }
+}
@@ -0,0 +1,129 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef FAST_MATH_HPP
+#define FAST_MATH_HPP
+
+// C++ and STL includes
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "cubemap_sampler.h"
+
+//
+// Polynomial spherical math for working out source positions
+//
+// fastAtan() is Abramowitz and Stegun's 4.4.49 minimax polynomial for atan on
+// 0..1, and fastAtan2Split() folds it out to the full circle with compares and
+// sign flips rather than branches, so the SSE2 and AVX2 row functions do exactly
+// the same operations in their lanes and give identical bits to the scalar one.
+// Measured against atan2 in double, fastAtan2() is within 3e-7 radians.
+//
+// The row functions keep the whole quarter turns of each angle apart from the
+// polynomial's part (at most 45 degrees) and add them in as exact multiples of
+// a quarter of the source size, so a position is only rounded once, like the
+// exact path's.  Measured over whole faces they land within one float step of
+// the exact position: 6e-5 source pixels on a 1000 pixel wide equirect, 2.4e-4
+// on a 4096 wide one and 4.9e-4 on a 6000 wide one, which is as close as a
+// float position that size can get, see fastMathErrorBound().  test_fast_math
+// checks this up to 16384 wide, and bench_image_to_cubemap reports it for every
+// size it runs.
+//
+// Elevation is taken as atan2(y, hypot(x, z)) rather than acos(y / |v|), since
+// acos loses most of its precision next to the poles.  |x|, |y| and |z| are at
+// most 1 on a cube face, so the hypotenuse can't overflow and is a plain sqrt.
+//
+
+const float FAST_MATH_HALF_PI = 1.57079632679490f;
+
+// atan(t) for t in 0..1
+inline float fastAtan(float t) {
+
+    const float t2 = t * t;
+    float p = 0.0028662257f;
+    p = p * t2 - 0.0161657367f;
+    p = p * t2 + 0.0429096138f;
+    p = p * t2 - 0.0752896400f;
+    p = p * t2 + 0.1065626393f;
+    p = p * t2 - 0.1420889944f;
+    p = p * t2 + 0.1999355085f;
+    p = p * t2 - 0.3333314528f;
+    return t + t * (t2 * p);
+}
+
+// atan2(y, x) as quarter_turns * pi / 2 + offset, with quarter_turns -2 .. 2 and
+// |offset| at most pi / 4, following atan2 for the signs of zeros too
+inline void fastAtan2Split(float y, float x, float& quarter_turns, float& offset) {
+
+    const float ax = std::fabs(x);
+    const float ay = std::fabs(y);
+    const float a = fastAtan(std::min(ax, ay) / std::max(std::max(ax, ay), FLT_MIN));
+
+    // Steeper than 45 degrees is a quarter turn less the angle from the y axis
+    const bool steep = ay > ax;
+    quarter_turns = steep ? 1.0f : 0.0f;
+    offset = steep ? -a : a;
+
+    // Pointing left is a half turn less that
+    const bool left = std::signbit(x);
+    quarter_turns = left ? 2.0f - quarter_turns : quarter_turns;
+    offset = left ? -offset : offset;
+
+    // Pointing down mirrors the lot
+    const bool down = std::signbit(y);
+    quarter_turns = down ? -quarter_turns : quarter_turns;
+    offset = down ? -offset : offset;
+}
+
+inline float fastAtan2(float y, float x) {
+
+    float quarter_turns, offset;
+    fastAtan2Split(y, x, quarter_turns, offset);
+    return quarter_turns * FAST_MATH_HALF_PI + offset;
+}
+
+// hypot(x, y) for arguments too small to overflow when squared
+inline float fastHypot(float x, float y) {
+    return std::sqrt(x * x + y * y);
+}
+
+// How far a fast math position may be from the exact one, in source pixels, for a
+// source size pixels across: one float step just below size, the finest a float
+// position that far out can resolve.  That's under a thousandth of a pixel up to
+// 8192 pixels and 9.8e-4 pixels from there up to 16384.
+inline double fastMathErrorBound(int size) {
+    const float far_edge = static_cast<float>(size);
+    return static_cast<double>(far_edge) - static_cast<double>(std::nextafter(far_edge, 0.0f));
+}
+
+// Turn count cube directions into positions in an inW x inH source, the same as sourcePosition():
+// uf = (atan2(x, z) + pi) * inW / (2 * pi) and vf = (pi / 2 - atan2(y, hypot(x, z))) * inH / pi
+typedef void (*SphericalRowFunction)(const float* x, const float* y, const float* z, int count,
+                                     int inW, int inH, float* uf, float* vf);
+
+// Pick the row function for a sampling kernel, all of them give identical results
+SphericalRowFunction sphericalRowFunction(SampleKernel kernel);
+
+#endif // FAST_MATH_HPP
@@ -0,0 +1,118 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HALF_FLOAT_X86 1
+#include <immintrin.h>
+#endif
+
+#include "half_float.h"
+
+//
+// Bit level float to half conversion
+//
+// Normal results round the mantissa to nearest even by hand, subnormal ones
+// let the FPU do the rounding by adding a magic number that lines the
+// mantissa bits up where the half's subnormal bits go.
+//
+quint16 floatToHalf(float value) {
+
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const quint32 sign = (bits >> 16) & 0x8000;
+    bits &= 0x7FFFFFFF;
+
+    quint32 half;
+    if (bits >= 0x47800000) {
+
+        // Too big for a half becomes infinity, NaN stays NaN
+        half = (bits > 0x7F800000) ? 0x7E00 : 0x7C00;
+    }
+    else if (bits < 0x38800000) {
+
+        // Subnormal half (or zero)
+        const quint32 magic_bits = 0x3F000000;  // ((127 - 15) + (23 - 10) + 1) << 23
+        float magic;
+        std::memcpy(&magic, &magic_bits, sizeof(magic));
+
+        float shifted;
+        std::memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += magic;
+
+        std::memcpy(&half, &shifted, sizeof(half));
+        half -= magic_bits;
+    }
+    else {
+        const quint32 mantissa_odd = (bits >> 13) & 1;
+        bits += 0xC8000FFF;                     // Rebias the exponent by (15 - 127) << 23, and round
+        bits += mantissa_odd;
+        half = bits >> 13;
+    }
+
+    return static_cast<quint16>(half | sign);
+}
+
+static void unormToHalfScalar(const quint16* in, int count, quint16* out) {
+
+    const float scale = 1.0f / 65535.0f;
+    for (int i = 0; i < count; ++i)
+        out[i] = floatToHalf(static_cast<float>(in[i]) * scale);
+}
+
+#ifdef HALF_FLOAT_X86
+
+// Eight values at a time: widen to 32 bits, scale in single precision, round with F16C
+__attribute__((target("avx2,f16c"))) static void unormToHalfF16C(const quint16* in, int count, quint16* out) {
+
+    const __m256 scale = _mm256_set1_ps(1.0f / 65535.0f);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        const __m256 value = _mm256_mul_ps(_mm256_cvtepi32_ps(wide), scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+    }
+
+    unormToHalfScalar(in + i, count - i, out + i);
+}
+
+#endif // HALF_FLOAT_X86
+
+void unormToHalf(const quint16* in, int count, quint16* out) {
+
+#ifdef HALF_FLOAT_X86
+    __builtin_cpu_init();
+    static const bool has_f16c = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c");
+    if (has_f16c) {
+        unormToHalfF16C(in, count, out);
+        return;
+    }
+#endif
+
+    unormToHalfScalar(in, count, out);
+}
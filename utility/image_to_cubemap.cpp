@@ -24,323 +24,386 @@ THE SOFTWARE.
 
 // C++ and STL includes
 #include <cstdint>
-#include <fstream>
+#include <cstdlib>
 #include <vector>
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <future>
 
-// Include libraw for DNG import
+// LibRaw includes
 #include <libraw/libraw.h>
 
 // Qt includes
 #include <QImage>
 #include <QImageReader>
-#include <QDataStream>
 #include <QFileInfo>
 #include <QString>
+#include <QStringList>
 #include <QColor>
-#include <QFile>
+#include <QJsonObject>
 
 #include "image_to_cubemap.h"
+#include "cubemap_convert.h"
+#include "area_filter.h"
+#include "cubemap_io.h"
+#include "ktx2_writer.h"
+#include "mipmap.h"
+#include "block_compress.h"
+#include "batch_pipeline.h"
+#include "stream_convert.h"
+#include "face_hashes.h"
+#include "stage_report.h"
+#include "png_writer.h"
 
 //
-// Function to load a DNG using libraw as a QImage
+// Print the command line options
 //
-QImage loadDNG(const QString& path) {
-
-    // Open the raw DNG file
-    LibRaw rawProcessor;
-    if (rawProcessor.open_file(path.toUtf8().data()) != LIBRAW_SUCCESS)
-        return QImage();
-
-    // Unpack DNG
-    rawProcessor.unpack();
-    rawProcessor.dcraw_process();
-
-    // Get a handle to the image data
-    libraw_processed_image_t* image = rawProcessor.dcraw_make_mem_image();
-
-    // Is this an RGB 8-bits per component DNG?
-    if (!image || image->colors != 3 || image->bits != 8)
-        return QImage();
+static void printUsage(void) {
+
+    std::cout << "Usage: ./image_to_cubemap [options] <input_image_path>\n"
+                 "       ./image_to_cubemap [options] <image|directory|@list_file>...\n"
+                 "Options:\n"
+                 "  -u, --unfolded            Input is an unfolded cubemap, only write the DDS\n"
+                 "  --incremental             With -u, only rewrite the faces that changed since the last run\n"
+                 "  -t, --threads N           Worker threads, 0 uses every core (default)\n"
+                 "  --simd KERNEL             auto, avx2, sse2 or scalar sampling kernel\n"
+                 "  --eac                     Equi-angular faces, even texel density, tagged in the DDS\n"
+                 "  --fast-math               Polynomial atan2 and hypot for source positions, bilinear only\n"
+                 "  --edge-percent N          Face edge in percent of a quarter of the input width\n"
+                 "  --ladder EDGES            Comma separated face edges, one decode, one DDS each\n"
+                 "  --filter FILTER           bilinear (default) or area, which prefilters small faces\n"
+                 "  --remap-cache DIR         Cache remap tables in DIR and reuse them\n"
+                 "  --memory-limit MB         Cap on image data in flight in batch mode\n"
+                 "  --no-png                  Only write the DDS, rendering faces straight into it\n"
+                 "  --layout LAYOUT           Unfolded PNG layout: 3x2 (default), 6x1 or cross for editing\n"
+                 "  --png-level N             PNG zlib level, 0 (fastest) to 9 (smallest), default 6\n"
+                 "  --no-mipmaps              Only write the full size level into the DDS\n"
+                 "  --format FORMAT           DDS pixel format: rgba (default), bc1, bc3, bc7 or bc6h\n"
+                 "  --quality LEVEL           BC6H encoder effort: fast, normal (default) or slow\n"
+                 "  --hdr                     Keep 16 bits per channel, write an RGBA16F DDS\n"
+                 "  --ktx2                    Write a Zstandard supercompressed KTX2 file instead of the DDS\n"
+                 "  --zstd-level N            KTX2 Zstandard level, 1 to 22 (default 9), implies --ktx2\n"
+                 "  --preview                 Quick small conversion, written as <name>_preview\n"
+                 "  --stream                  Convert a JPEG/PNG panorama in strips, DDS only\n"
+                 "  --memory-budget MB        Memory for streaming, implies --stream\n"
+                 "  --report FILE             Write the time, CPU time, bytes and peak memory of each stage as JSON\n"
+              << std::endl;
+}
 
-    // Yes, create a new QImage with the DNG data
-    QImage qimg(image->width, image->height, QImage::Format_RGB888);
-    memcpy(qimg.bits(), image->data, image->height * image->width * 3);
+// Bytes of the six faces and their mip chains, as far as they've been built
+static qint64 cubemapBytes(const FaceViews& faces, const CubemapMips* mips) {
 
-    // Cleanup
-    LibRaw::dcraw_clear_mem(image);
-    rawProcessor.recycle();
-    return qimg;
+    qint64 bytes = 6 * static_cast<qint64>(faces.edge) * faces.edge * (faces.depth / 8);
+    if (mips)
+        for (int face = 0; face < 6; ++face)
+            bytes += static_cast<qint64>(mips->faces[face].size());
+    return bytes;
 }
 
-//
-// Function to write provided QImage as a DDS file to the save_file_path provided
-//
-bool writeCubemapToDDS(const QImage& cubemapImage, const QString& save_file_path) {
+// 
+// Application begins
+// 
+int main(int argc, char** argv) {
 
-    std::ofstream file(save_file_path.toStdString(), std::ios::out | std::ios::binary);
-    if (!file) {
-        std::cerr << "Could not open file for writing: " << save_file_path.toStdString() << std::endl;
-        return false;
+    bool unfolded = false;
+    bool incremental = false;
+    int threads = 0;
+    SampleKernel kernel = SampleKernel::Auto;
+    SampleFilter filter = SampleFilter::Bilinear;
+    CubeProjection projection = CubeProjection::Standard;
+    bool fast_math = false;
+    int edge_percent = 100;
+    std::vector<int> ladder;
+    QString remap_cache_dir;
+    qint64 memory_limit_mb = 0;
+    bool stream = false;
+    bool write_png = true;
+    int png_level = PNG_ZLIB_LEVEL;
+    CubemapLayout layout = CubemapLayout::Grid3x2;
+    bool layout_given = false;
+    bool mipmaps = true;
+    BlockFormat block_format = BlockFormat::None;
+    BlockQuality block_quality = BlockQuality::Normal;
+    bool hdr = false;
+    bool ktx2 = false;
+    int zstd_level = KTX2_ZSTD_LEVEL;
+    bool preview = false;
+    qint64 memory_budget_mb = 0;
+    QString report_path;
+    QStringList input_arguments;
+
+    // Make sure user provided an input image
+    if (argc < 2) {
+        printUsage();
+        return 1;
     }
 
-    int outW = cubemapImage.width();
-    int edge = outW / 4;
-    int bytesPerPixel = 4; // For RGBA8888
-
-    // 1. Define and populate the header
-    DDS_HEADER header = {};
-    header.dwSize = sizeof(DDS_HEADER);
-    header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_PITCH;
-    header.dwHeight = edge;
-    header.dwWidth = edge;
-    header.dwPitchOrLinearSize = edge * bytesPerPixel;
-    header.dwMipMapCount = 1; // No mipmaps for this example
-    header.ddspf.dwSize = sizeof(DDS_PIXELFORMAT);
-    header.ddspf.dwFlags = DDPF_RGB | DDPF_ALPHAPIXELS;
-    header.ddspf.dwRGBBitCount = 32;
-    header.ddspf.dwRBitMask = 0x00FF0000;
-    header.ddspf.dwGBitMask = 0x0000FF00;
-    header.ddspf.dwBBitMask = 0x000000FF;
-    header.ddspf.dwABitMask = 0xFF000000;
-    header.dwCaps = DDSCAPS_COMPLEX | DDSCAPS_TEXTURE;
-    header.dwCaps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES;
-
-    // 2. Write the magic number and header
-    file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(quint32));
-    file.write(reinterpret_cast<const char*>(&header), sizeof(DDS_HEADER));
-
-    // 3. Extract and write pixel data for each face
-    // DDS cubemap face order: +X, -X, +Y, -Y, +Z, -Z
-    
-    // We'll use our previous logic to extract faces but convert to raw data
-    // The QImage format needs to be compatible with RGBA8888
-    const QImage& img = cubemapImage.convertToFormat(QImage::Format_RGBA8888);
-
-    // +X (Right)
-    QImage facePX = img.copy(2 * edge, edge, edge, edge);
-    file.write(reinterpret_cast<const char*>(facePX.constBits()), facePX.sizeInBytes());
-
-    // -X (Left)
-    QImage faceNX = img.copy(0, edge, edge, edge);
-    file.write(reinterpret_cast<const char*>(faceNX.constBits()), faceNX.sizeInBytes());
-
-    // +Y (Top)
-    QImage facePY = img.copy(edge, 0, edge, edge);
-    file.write(reinterpret_cast<const char*>(facePY.constBits()), facePY.sizeInBytes());
-
-    // -Y (Bottom)
-    QImage faceNY = img.copy(edge, 2 * edge, edge, edge);
-    file.write(reinterpret_cast<const char*>(faceNY.constBits()), faceNY.sizeInBytes());
-    
-    // +Z (Front)
-    QImage facePZ = img.copy(edge, edge, edge, edge);
-    file.write(reinterpret_cast<const char*>(facePZ.constBits()), facePZ.sizeInBytes());
-
-    // -Z (Back)
-    QImage faceNZ = img.copy(3 * edge, edge, edge, edge);
-    file.write(reinterpret_cast<const char*>(faceNZ.constBits()), faceNZ.sizeInBytes());
-
-    // Done writing DDS
-    file.close();
-
-    return true;
-}
+    for (int argIndex = 1; argIndex < argc; ++argIndex) {
 
-// Convert output image coordinates to 3D coordinates
-// This function maps a pixel in a specific face of the cubemap to a 3D vector.
-// The face is determined by the `face` parameter.
-void outImgToXYZ(int i, int j, int face, int edge, float& x, float& y, float& z) {
-
-    // Correctly scale i and j to a -1 to 1 range for each face
-    // i and j are relative to the top-left of the current face
-    const float a = 2.0f * (float)i / (float)edge - 1.0f;
-    const float b = 2.0f * (float)j / (float)edge - 1.0f;
-
-    switch (face) {
-
-        // We'll use a standard cubemap face order:
-        // 0: right (+X)
-        // 1: left (-X)
-        // 2: top (+Y)
-        // 3: bottom (-Y)
-        // 4: front (+Z)
-        // 5: back (-Z)
-
-        // Right (+X) face
-        case 0: x = 1.0f; y = -b; z = -a; break; 
-        
-        // Left (-X) face
-        case 1: x = -1.0f; y = -b; z = a; break; 
-        
-        // Top (+Y) face
-        case 2: x = a; y = 1.0f; z = b; break; 
-        
-        // Bottom (-Y) face
-        case 3: x = a; y = -1.0f; z = -b; break; 
-        
-        // Front (+Z) face
-        case 4: x = a; y = -b; z = 1.0f; break; 
-        
-        // Back (-Z) face
-        case 5: x = -a; y = -b; z = -1.0f; break;
-        
-        default: x = y = z = 0; break;
-    }
-}
-
-// Main conversion logic
-void convertEquirectToCubemap(const QImage& image_in, QImage& image_out) {
+        const std::string arg(argv[argIndex]);
 
-    const int inW = image_in.width();
-    const int inH = image_in.height();
-    const int outW = image_out.width();
-    const int outH = image_out.height();
-    
-    // The cubemap output image should be a 4x3 grid of faces,
-    // so the edge length of a single face is outW / 4.
-    const int edge = outW / 4;
-
-    std::cout << "Edge length in pixels: " << edge << std::endl;
-    std::cout << "Output image dimensions: " << outW << "x" << outH << std::endl;
-
-    for (int i = 0; i < outW; ++i) {
-
-        if (i % 1000 == 0)
-            std::cout << "Processing " << i << " of " << outW << std::endl;
-
-        for (int j = 0; j < outH; ++j) {
-            int currentFace = -1;
-            int i_face = -1;
-            int j_face = -1;
-
-            // Determine which face and its local coordinates
-            // We want the Top and Bottom cubes to align vertically with the Front cube.
-            // This is a common arrangement. The layout will be:
-            //       +---+
-            //       | T |
-            //   +---+---+---+---+
-            //   | L | F | R | B |
-            //   +---+---+---+---+
-            //       | D |
-            //       +---+
-
-            // Top face (+Y), centered over the Front face
-            if (i >= edge && i < 2 * edge && j < edge) {
-                currentFace = 2;
-                i_face = i - edge;
-                j_face = j;
+        // Check for optional arguments
+        if (arg == "-u" || arg == "--unfolded") {
+            unfolded = true;
+        }
+        else if (arg == "--incremental") {
+            incremental = true;
+        }
+        else if (arg == "-t" || arg == "--threads") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs a thread count\n";
+                return 1;
             }
-            // Front face (+Z)
-            else if (i >= edge && i < 2 * edge && j >= edge && j < 2 * edge) {
-                currentFace = 4;
-                i_face = i - edge;
-                j_face = j - edge;
+            threads = atoi(argv[argIndex]);
+        }
+        else if (arg == "--simd") {
+            const std::string name = (++argIndex < argc) ? argv[argIndex] : "";
+            if (name == "auto")
+                kernel = SampleKernel::Auto;
+            else if (name == "avx2")
+                kernel = SampleKernel::AVX2;
+            else if (name == "sse2")
+                kernel = SampleKernel::SSE2;
+            else if (name == "scalar")
+                kernel = SampleKernel::Scalar;
+            else {
+                std::cerr << "Error: --simd must be one of auto, avx2, sse2 or scalar\n";
+                return 1;
             }
-            // Bottom face (-Y), centered under the Front face
-            else if (i >= edge && i < 2 * edge && j >= 2 * edge) {
-                currentFace = 3;
-                i_face = i - edge;
-                j_face = j - 2 * edge;
+        }
+        else if (arg == "--eac") {
+            projection = CubeProjection::EquiAngular;
+        }
+        else if (arg == "--fast-math") {
+            fast_math = true;
+        }
+        else if (arg == "--edge-percent") {
+            if (++argIndex >= argc || atoi(argv[argIndex]) < 1 || atoi(argv[argIndex]) > 400) {
+                std::cerr << "Error: " << arg << " needs a percentage from 1 to 400\n";
+                return 1;
             }
-            // Left face (-X)
-            else if (i < edge && j >= edge && j < 2 * edge) {
-                currentFace = 1;
-                i_face = i;
-                j_face = j - edge;
+            edge_percent = atoi(argv[argIndex]);
+        }
+        else if (arg == "--ladder") {
+            const QStringList edges = (++argIndex < argc) ? QString::fromStdString(argv[argIndex]).split(',') : QStringList();
+            for (const QString& edge : edges) {
+                bool ok = false;
+                ladder.push_back(edge.trimmed().toInt(&ok));
+                if (!ok || ladder.back() < 1) {
+                    std::cerr << "Error: --ladder needs comma separated face edges, such as 512,1024,2048\n";
+                    return 1;
+                }
             }
-            // Right face (+X)
-            else if (i >= 2 * edge && i < 3 * edge && j >= edge && j < 2 * edge) {
-                currentFace = 0;
-                i_face = i - 2 * edge;
-                j_face = j - edge;
+            if (ladder.empty()) {
+                std::cerr << "Error: --ladder needs comma separated face edges, such as 512,1024,2048\n";
+                return 1;
             }
-            // Back face (-Z)
-            else if (i >= 3 * edge && i < 4 * edge && j >= edge && j < 2 * edge) {
-                currentFace = 5;
-                i_face = i - 3 * edge;
-                j_face = j - edge;
+        }
+        else if (arg == "--filter") {
+            const std::string name = (++argIndex < argc) ? argv[argIndex] : "";
+            if (name == "bilinear")
+                filter = SampleFilter::Bilinear;
+            else if (name == "area")
+                filter = SampleFilter::Area;
+            else {
+                std::cerr << "Error: --filter must be one of bilinear or area\n";
+                return 1;
             }
-            
-            if (currentFace != -1) {
-
-                float x, y, z;
-                outImgToXYZ(i_face, j_face, currentFace, edge, x, y, z);
-
-                // Convert 3D vector to spherical coordinates
-                const float theta = atan2(x, z);
-                const float phi = atan2(y, hypot(x, z));
-
-                // Convert spherical coordinates back to equirectangular coordinates
-                const float uf = (inW * (theta + M_PI)) / (2 * M_PI);
-                const float vf = (inH * (M_PI / 2.0f - phi)) / M_PI;
-
-                const int ui = static_cast<int>(floor(uf));
-                const int vi = static_cast<int>(floor(vf));
-                
-                const int u2 = ui + 1;
-                const int v2 = vi + 1;
-
-                const float mu = uf - ui;
-                const float nu = vf - vi;
-
-                // Bilinear interpolation
-                const QColor A = image_in.pixelColor(ui % inW, clip(vi, 0, inH - 1));
-                const QColor B = image_in.pixelColor(u2 % inW, clip(vi, 0, inH - 1));
-                const QColor C = image_in.pixelColor(ui % inW, clip(v2, 0, inH - 1));
-                const QColor D = image_in.pixelColor(u2 % inW, clip(v2, 0, inH - 1));
-                
-                const int rVal = static_cast<int>(round(A.red() * (1 - mu) * (1 - nu) + B.red() * mu * (1 - nu) + C.red() * (1 - mu) * nu + D.red() * mu * nu));
-                const int gVal = static_cast<int>(round(A.green() * (1 - mu) * (1 - nu) + B.green() * mu * (1 - nu) + C.green() * (1 - mu) * nu + D.green() * mu * nu));
-                const int bVal = static_cast<int>(round(A.blue() * (1 - mu) * (1 - nu) + B.blue() * mu * (1 - nu) + C.blue() * (1 - mu) * nu + D.blue() * mu * nu));
-
-                image_out.setPixelColor(i, j, QColor(rVal, gVal, bVal));
-
-            } else {
-
-                // Set non-cube areas to black
-                image_out.setPixelColor(i, j, Qt::black);
+        }
+        else if (arg == "--remap-cache") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs a directory\n";
+                return 1;
+            }
+            remap_cache_dir = QString::fromStdString(argv[argIndex]);
+        }
+        else if (arg == "--memory-limit") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs a size in MB\n";
+                return 1;
             }
+            memory_limit_mb = atoll(argv[argIndex]);
+        }
+        else if (arg == "--no-png") {
+            write_png = false;
+        }
+        else if (arg == "--layout") {
+            const std::string name = (++argIndex < argc) ? argv[argIndex] : "";
+            if (name == "3x2")
+                layout = CubemapLayout::Grid3x2;
+            else if (name == "6x1")
+                layout = CubemapLayout::Strip6x1;
+            else if (name == "cross")
+                layout = CubemapLayout::Cross;
+            else {
+                std::cerr << "Error: --layout must be one of 3x2, 6x1 or cross\n";
+                return 1;
+            }
+            layout_given = true;
+        }
+        else if (arg == "--png-level") {
+            if (++argIndex >= argc || argv[argIndex][0] < '0' || argv[argIndex][0] > '9' || argv[argIndex][1] != '\0') {
+                std::cerr << "Error: " << arg << " needs a level from 0 to 9\n";
+                return 1;
+            }
+            png_level = atoi(argv[argIndex]);
+        }
+        else if (arg == "--no-mipmaps") {
+            mipmaps = false;
+        }
+        else if (arg == "--format") {
+            const std::string name = (++argIndex < argc) ? argv[argIndex] : "";
+            if (name == "rgba")
+                block_format = BlockFormat::None;
+            else if (name == "bc1")
+                block_format = BlockFormat::BC1;
+            else if (name == "bc3")
+                block_format = BlockFormat::BC3;
+            else if (name == "bc7")
+                block_format = BlockFormat::BC7;
+            else if (name == "bc6h")
+                block_format = BlockFormat::BC6H;
+            else {
+                std::cerr << "Error: --format must be one of rgba, bc1, bc3, bc7 or bc6h\n";
+                return 1;
+            }
+        }
+        else if (arg == "--quality") {
+            const std::string name = (++argIndex < argc) ? argv[argIndex] : "";
+            if (name == "fast")
+                block_quality = BlockQuality::Fast;
+            else if (name == "normal")
+                block_quality = BlockQuality::Normal;
+            else if (name == "slow")
+                block_quality = BlockQuality::Slow;
+            else {
+                std::cerr << "Error: --quality must be one of fast, normal or slow\n";
+                return 1;
+            }
+        }
+        else if (arg == "--hdr") {
+            hdr = true;
+        }
+        else if (arg == "--ktx2") {
+            ktx2 = true;
+        }
+        else if (arg == "--zstd-level") {
+            if (++argIndex >= argc || atoi(argv[argIndex]) < 1 || atoi(argv[argIndex]) > 22) {
+                std::cerr << "Error: " << arg << " needs a level from 1 to 22\n";
+                return 1;
+            }
+            zstd_level = atoi(argv[argIndex]);
+            ktx2 = true;
+        }
+        else if (arg == "--preview") {
+            preview = true;
+        }
+        else if (arg == "--report") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: --report needs a file name\n";
+                return 1;
+            }
+            report_path = QString::fromLocal8Bit(argv[argIndex]);
+        }
+        else if (arg == "--stream") {
+            stream = true;
+        }
+        else if (arg == "--memory-budget") {
+            if (++argIndex >= argc) {
+                std::cerr << "Error: " << arg << " needs a size in MB\n";
+                return 1;
+            }
+            memory_budget_mb = atoll(argv[argIndex]);
+            stream = true;
+        }
+        else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Error: unknown option: " << arg << "\n";
+            return 1;
+        }
+        // Otherwise expect image file paths, directories or @lists
+        else {
+            input_arguments.push_back(QString::fromStdString(arg));
         }
     }
-}
-
-// 
-// Application begins
-// 
-int main(int argc, char** argv) {
 
-    bool unfolded = false;
-    QString input_image_path;
+    if (input_arguments.empty()) {
+        std::cerr << "Error: missing required argument: <input_image_path>\n";
+        return 1;
+    }
 
-    // Make sure user provided an input image, and nothing more for now
-    if (argc < 2) {
-        std::cout << "Usage: ./image_to_cubemap [-u|--unfolded] <input_image_path>" << std::endl;
+    // BC6H is compressed from the 16-bit faces, the BC1/BC3/BC7 encoders only take 8-bit faces
+    if (block_format == BlockFormat::BC6H)
+        hdr = true;
+    else if (hdr && block_format != BlockFormat::None) {
+        std::cerr << "Error: --hdr writes RGBA16F or BC6H and can't be combined with --format " << blockFormatName(block_format) << "\n";
         return 1;
     }
 
-    int argIndex = 1;
+    // A ladder sets every face size itself, from one decoded equirectangular image
+    if (!ladder.empty() && (unfolded || stream || edge_percent != 100)) {
+        std::cerr << "Error: --ladder can't be combined with --unfolded, --stream or --edge-percent\n";
+        return 1;
+    }
 
-    // Check for optional argument
-    if (std::string(argv[argIndex]) == "-u" || std::string(argv[argIndex]) == "--unfolded") {
-        unfolded = true;
-        ++argIndex;
+    // Only an edited unfolded cubemap is compared face by face with the last run, and only a DDS is patched in place
+    if (incremental && (!unfolded || ktx2 || stream || preview)) {
+        std::cerr << "Error: --incremental needs --unfolded and updates a DDS, it can't be combined with --ktx2, --stream or --preview\n";
+        return 1;
     }
 
-    // Now expect the image file path
-    if (argIndex < argc) {
-        input_image_path = QString::fromStdString(argv[argIndex]);
-    } else {
-        std::cerr << "Error: missing required argument: <input_image_path>\n";
+    // An unfolded input is read in whichever layout its shape says it is in
+    if (unfolded && layout_given) {
+        std::cerr << "Error: --layout picks the layout of the PNG written, -u tells the layout of its input from its shape\n";
         return 1;
     }
 
+    // A thread count of 0 uses every core
+    ThreadPool pool(threads);
+
+    // More than one image, a directory or a file list runs as a batch
+    const QString& first_input = input_arguments.front();
+    if (input_arguments.size() > 1 || first_input.startsWith("@") || QFileInfo(first_input).isDir()) {
+
+        if (!ladder.empty() || incremental || !report_path.isEmpty()) {
+            std::cerr << "Error: --ladder, --incremental and --report convert one image at a time\n";
+            return 1;
+        }
+
+        QImageReader::setAllocationLimit(1000);
+
+        BatchOptions options;
+        options.unfolded = unfolded;
+        options.write_png = write_png;
+        options.png_level = png_level;
+        options.layout = layout;
+        options.mipmaps = mipmaps;
+        options.block_format = block_format;
+        options.block_quality = block_quality;
+        options.hdr = hdr;
+        options.ktx2 = ktx2;
+        options.zstd_level = zstd_level;
+        options.preview = preview;
+        options.convert.kernel = kernel;
+        options.convert.filter = filter;
+        options.convert.projection = projection;
+        options.convert.fast_math = fast_math;
+        options.edge_percent = edge_percent;
+        options.remap_cache_dir = remap_cache_dir;
+        options.memory_limit = memory_limit_mb * 1024 * 1024;
+
+        std::cout << "Threads: " << pool.threadCount() << "\n";
+        const QStringList inputs = collectBatchInputs(input_arguments, unfolded);
+        return runBatch(inputs, options, pool) == 0 ? 0 : 1;
+    }
+
+    const QString input_image_path = first_input;
+
     // Done parsing, now use the values
     std::cout << "Unfolded option: " << (unfolded ? "true" : "false") << "\n";
     std::cout << "Filename: " << input_image_path.toStdString() << "\n";
 
+    std::cout << "Threads: " << pool.threadCount() << "\n";
 
     // Get the user's image path
     QFileInfo file_info(input_image_path);
@@ -348,59 +411,338 @@ int main(int argc, char** argv) {
     // Compute the input file's extension
     QString extension = file_info.suffix().toLower();
     QString path_no_extension = file_info.path() + "/" + file_info.completeBaseName();
+    if (preview)
+        path_no_extension += "_preview";
     printf("Extension: '%s'\n", extension.toStdString().c_str());
 
-    // Compute the output DDS cubemap filename
-    QString output_dds = path_no_extension + ".dds";
-    printf("DDS: '%s'\n", output_dds.toStdString().c_str());
+    // Compute the output DDS (or KTX2) cubemap filename
+    const char* texture_type = ktx2 ? "KTX2" : "DDS";
+    const QString texture_extension = ktx2 ? ".ktx2" : ".dds";
+    QString output_dds = path_no_extension + texture_extension;
+    printf("%s: '%s'\n", texture_type, output_dds.toStdString().c_str());
 
     // Compute the output PNG filename
     QString output_png = path_no_extension + ".png";
     printf("PNG: '%s'\n", output_png.toStdString().c_str());
 
-    // Make sure Qt will deal with large images
-    QImageReader::setAllocationLimit(1000);
+    // Every stage is timed from the end of the one before, its peak memory is printed and
+    // everything goes into the --report JSON
+    StageReport stage_report;
+    auto finishStage = [&](const char* stage, qint64 bytes_in, qint64 bytes_out, int edge) {
+        const StageRecord& record = stage_report.finish(stage, bytes_in, bytes_out, edge);
+        std::cout << "Peak resident memory, " << stage << ": " << record.peak_resident / (1024 * 1024) << " MB" << std::endl;
+    };
+
+    // Write the report once the conversion is done, a run without --report always succeeds here
+    auto saveReport = [&]() {
+
+        if (report_path.isEmpty())
+            return true;
+
+        QJsonObject report;
+        report["tool"] = "image_to_cubemap";
+        report["input"] = input_image_path;
+        report["threads"] = pool.threadCount();
+        report["qt_version"] = qVersion();
+        report["libraw_version"] = LibRaw::version();
+
+        if (!stage_report.save(report_path, report)) {
+            std::cerr << "Failed to write the report to " << report_path.toStdString() << std::endl;
+            return false;
+        }
+        std::cout << "Saved report: " << report_path.toStdString() << std::endl;
+        return true;
+    };
 
-    QImage image_in;
+    // Gigapixel panoramas are converted strip by strip straight into the DDS
+    if (stream) {
+
+        if (block_format != BlockFormat::None || hdr || ktx2) {
+            std::cerr << "Error: --stream only writes uncompressed 8-bit DDS files\n";
+            return 1;
+        }
+        if (preview) {
+            std::cerr << "Error: --stream converts the whole panorama and can't make a preview\n";
+            return 1;
+        }
+        if (filter != SampleFilter::Bilinear) {
+            std::cerr << "Error: --stream only samples bilinearly\n";
+            return 1;
+        }
 
-    // Are we reading raw?
-    if (extension == "dng")
-        // Yes, load the raw DNG equirectangular image
-        image_in = loadDNG(input_image_path);
-    else {
+        StreamOptions options;
+        options.kernel = kernel;
+        options.projection = projection;
+        options.fast_math = fast_math;
+        options.edge_percent = edge_percent;
+        if (memory_budget_mb > 0)
+            options.memory_budget = memory_budget_mb * 1024 * 1024;
 
-        // No, load the raw PNG/JPG file
-        if (!image_in.load(input_image_path)) {
-            std::cerr << "Failed to load image: " << input_image_path.toStdString() << std::endl;
+        if (!streamEquirectToDDS(input_image_path, output_dds, pool, options))
             return 1;
+
+        std::cout << "Saved Cubemap to DDS: " << output_dds.toStdString() << std::endl;
+
+        // Decoding, converting and writing all overlap, so streaming is one stage
+        finishStage("stream", file_info.size(), QFileInfo(output_dds).size(), 0);
+        return saveReport() ? 0 : 1;
+    }
+
+    // Make sure Qt will deal with large images
+    QImageReader::setAllocationLimit(1000);
+
+    // Faces get their edge from the full size of a JPEG, which then only has to be decoded
+    // large enough to cover four of them across (or the largest size in a ladder)
+    QSize jpeg_size;
+    int jpeg_edge = 0;
+    int min_width = 0;
+    if (!unfolded && !preview && (extension == "jpg" || extension == "jpeg")) {
+        jpeg_size = probeImageSize(input_image_path);
+        if (jpeg_size.isValid()) {
+            jpeg_edge = cubemapEdge(jpeg_size.width(), edge_percent);
+            min_width = 4 * (ladder.empty() ? jpeg_edge : *std::max_element(ladder.begin(), ladder.end()));
         }
     }
 
-    QImage image_unfolded;
+    // Load the raw DNG or PNG/JPG file
+    QImage image_in = loadInputImage(input_image_path, hdr, preview, min_width);
+    if (image_in.isNull()) {
+        std::cerr << "Failed to load image: " << input_image_path.toStdString() << std::endl;
+        return 1;
+    }
+    if (jpeg_size.isValid() && image_in.width() < jpeg_size.width())
+        std::cout << "Decoded at 1/" << jpeg_size.width() / image_in.width() << " scale: "
+                  << image_in.width() << "x" << image_in.height() << std::endl;
+    finishStage("load", file_info.size(), image_in.sizeInBytes(), 0);
 
-    if (unfolded) {
-        // Source is assumed to be unfolded already, so just assign it
-        image_unfolded = image_in;
+    // Faces are read straight out of an unfolded cubemap, so it has to be exactly whole faces
+    if (unfolded && !checkUnfoldedCubemap(image_in.width(), image_in.height(), input_image_path))
+        return 1;
+
+    // Sample points keep their rows in 16 bits, turn a panorama that's too tall away before a ladder builds its pyramid
+    if (!unfolded && image_in.height() > SAMPLE_MAX_SOURCE_HEIGHT) {
+        std::cerr << "Error: panoramas can be at most " << SAMPLE_MAX_SOURCE_HEIGHT << " rows tall, "
+                  << input_image_path.toStdString() << " has " << image_in.height() << std::endl;
+        return 1;
     }
-    else {
-        // Create a black image to fill as unfolded cubemap
-        int outHeight = image_in.width() * 3 / 4;
-        QImage image_out(image_in.width(), outHeight, QImage::Format_RGB32);
-        image_out.fill(Qt::black);
+
+    // Convert one equirectangular image (or unfolded cubemap) into faces of edge
+    // pixels and save them, reading from a shared source pyramid if one is given.
+    // False if the cubemap couldn't be saved.
+    auto convertAndSave = [&](QImage image_in, int edge, const SourcePyramid* pyramid,
+                              const QString& output_png, const QString& output_dds) -> bool {
+
+        const qint64 input_bytes = image_in.sizeInBytes();
+
+        ConvertOptions options;
+        options.kernel = kernel;
+        options.filter = filter;
+        options.projection = projection;
+        options.fast_math = fast_math;
+        options.pyramid = pyramid;
+
+        // Reuse (or start) a cached remap table for this input size, the area filter doesn't use one
+        RemapTable remap;
+        if (!unfolded && filter == SampleFilter::Bilinear && !remap_cache_dir.isEmpty() &&
+            remap.loadOrBuild(remap_cache_dir, image_in.width(), image_in.height(), edge, pool, projection))
+            options.remap = &remap;
+
+        // The image holding the faces, either the unfolded cubemap in the --layout (or the
+        // input's) layout or a face stack, at 16 bits per channel for high bit depth output
+        const QImage::Format face_format = hdr ? QImage::Format_RGBA64 : QImage::Format_RGB32;
+        QImage image_faces;
+        bool face_stack = false;
+        std::future<bool> png_saved;
+
+        if (unfolded) {
+
+            // Source is assumed to be unfolded already, its faces go straight into the DDS
+            image_faces = hdr ? makeSourceImage64(image_in) : makeSourceImage(image_in);
+            image_in = QImage();
+            CubemapLayout layout = CubemapLayout::Cross;
+            detectCubemapLayout(image_faces.width(), image_faces.height(), layout);
+            std::cout << "Unfolded layout: " << cubemapLayoutName(layout) << std::endl;
+        }
+        else if (!write_png) {
+
+            // Without a PNG the faces are rendered straight into DDS order, so this
+            // single face stack is the only output buffer the conversion needs
+            image_faces = QImage(edge, 6 * edge, face_format);
+            if (!convertEquirectToFaceStack(image_in, image_faces, pool, options))
+                return false;
+            face_stack = true;
+
+            // The input isn't needed any more
+            image_in = QImage();
+            finishStage("convert", input_bytes, image_faces.sizeInBytes(), edge);
+        }
+        else {
+            // Create the unfolded cubemap, only the cross has cells left black
+            QImage image_unfolded(cubemapLayoutSize(layout, edge), face_format);
     
-        // Fill the cubemap image using the equirectangular image 
-        convertEquirectToCubemap(image_in, image_unfolded);
+            // Fill the cubemap image using the equirectangular image 
+            if (!convertEquirectToCubemap(image_in, image_unfolded, pool, options))
+                return false;
+            image_in = QImage();
+            finishStage("convert", input_bytes, image_unfolded.sizeInBytes(), edge);
     
-        // Save the cubemap first as a PNG
-        std::cout << "Saving Cubemap to PNG: " << output_png.toStdString() << std::endl;
-        image_unfolded.save(output_png);
-        std::cout << "Saved Cubemap to PNG: " << output_png.toStdString() << std::endl;
+            // The PNG is compressed in the background while the faces go on to the mips and DDS.
+            // The pool can only be driven from this thread, so the PNG gets one of its own, a
+            // quarter the size so the two don't oversubscribe the cores the mips and DDS run on
+            std::cout << "Saving Cubemap to PNG: " << output_png.toStdString() << std::endl;
+            const int png_threads = std::max(1, pool.threadCount() / 4);
+            png_saved = std::async(std::launch::async, [image_unfolded, output_png, png_level, png_threads]() {
+                ThreadPool png_pool(png_threads);
+                return writePNG(image_unfolded, output_png, png_level, &png_pool);
+            });
+
+            image_faces = image_unfolded;
+        }
+
+        FaceViews faces;
+        if (face_stack)
+            faces = faceStackViews(image_faces);
+        else if (!unfoldedFaceViews(image_faces, faces))
+            return false;
+
+        // An incremental update compares each face with the hashes saved by the last run,
+        // the faces that didn't change keep their mips and blocks in the existing DDS
+        FaceHashes hashes;
+        int face_mask = CUBEMAP_ALL_FACES;
+        if (incremental) {
+            hashes.settings = QString("edge %1, %2 levels, %3, quality %4, %5")
+                .arg(edge)
+                .arg(mipmaps ? mipLevelCount(edge) : 1)
+                .arg(block_format != BlockFormat::None ? blockFormatName(block_format) : (hdr ? "rgba16f" : "rgba"))
+                .arg(static_cast<int>(block_quality))
+                .arg(projection == CubeProjection::EquiAngular ? "eac" : "standard");
+            hashCubemapFaces(faces, pool, hashes);
+
+            face_mask = staleCubemapFaces(output_dds, hashes);
+            if (face_mask == 0) {
+                std::cout << "No faces changed, " << output_dds.toStdString() << " is up to date" << std::endl;
+                return true;
+            }
+
+            int changed = 0;
+            for (int face = 0; face < 6; ++face)
+                changed += (face_mask >> face) & 1;
+            std::cout << "Rewriting " << changed << " of 6 faces" << std::endl;
+        }
+
+        // The smaller levels of each face follow it in the DDS
+        CubemapMips mips;
+        if (mipmaps) {
+            buildCubemapMips(faces, pool, mips, face_mask);
+            finishStage("mipmaps", cubemapBytes(faces, nullptr), cubemapBytes(faces, &mips) - cubemapBytes(faces, nullptr), edge);
+        }
+        const CubemapMips* dds_mips = mipmaps ? &mips : nullptr;
+
+        CompressedCubemap compressed;
+        if (block_format != BlockFormat::None) {
+            compressCubemap(faces, dds_mips, block_format, pool, compressed, block_quality, face_mask);
+            finishStage("compress", cubemapBytes(faces, dds_mips), static_cast<qint64>(compressed.data.size()), edge);
+        }
+
+        // Then save the faces as a KTX2, with every level supercompressed on the pool, or as a DDS
+        bool saved = true;
+        if (ktx2) {
+            Ktx2Cubemap supercompressed;
+            const bool encoded = (block_format != BlockFormat::None)
+                ? encodeCompressedCubemapKTX2(compressed, pool, supercompressed, zstd_level)
+                : encodeCubemapKTX2(faces, dds_mips, pool, supercompressed, zstd_level);
+            if (!encoded)
+                std::cerr << "Failed to supercompress the KTX2 levels for: " << output_dds.toStdString() << std::endl;
+            saved = encoded && writeKTX2(supercompressed, output_dds, projection);
+        }
+        else {
+            bool written = false;
+            if (block_format != BlockFormat::None)
+                written = writeCompressedCubemapToDDS(compressed, output_dds, projection, face_mask, &pool);
+            else if (hdr)
+                written = writeHalfCubemapToDDS(faces, dds_mips, output_dds, projection, face_mask, &pool);
+            else if (face_stack)
+                written = writeFaceStackToDDS(image_faces, output_dds, dds_mips, projection, &pool);
+            else
+                written = writeCubemapToDDS(image_faces, output_dds, dds_mips, projection, face_mask, &pool);
+
+            // The next incremental run starts from the faces just written
+            if (incremental && written && !saveFaceHashes(output_dds, hashes))
+                std::cerr << "Could not save face hashes for: " << output_dds.toStdString() << std::endl;
+            saved = written;
+        }
+
+        if (!saved) {
+            std::cerr << "Failed to save Cubemap to " << texture_type << ": " << output_dds.toStdString() << std::endl;
+            return false;
+        }
+
+        std::cout << "Saved Cubemap to " << texture_type << ": " << output_dds.toStdString() << std::endl;
+        finishStage(ktx2 ? "ktx2" : "dds", (block_format != BlockFormat::None) ? static_cast<qint64>(compressed.data.size()) : cubemapBytes(faces, dds_mips),
+                    QFileInfo(output_dds).size(), edge);
+
+        // Only the time still spent waiting for the PNG after the DDS counts as its stage
+        if (png_saved.valid()) {
+            if (!png_saved.get()) {
+                std::cerr << "Failed to save PNG: " << output_png.toStdString() << std::endl;
+                return false;
+            }
+            std::cout << "Saved Cubemap to PNG: " << output_png.toStdString() << std::endl;
+            finishStage("png", image_faces.sizeInBytes(), QFileInfo(output_png).size(), edge);
+        }
+
+        return true;
+    };
+
+    // A ladder converts the one decode to every face size in turn, each size
+    // reads the smallest pyramid level still at least four of its faces wide
+    if (!ladder.empty()) {
+
+        SourcePyramid pyramid;
+        buildSourcePyramid(hdr ? makeSourceImage64(image_in) : makeSourceImage(image_in), pool, pyramid);
+        std::cout << "Built a " << pyramid.levels.size() << " level source pyramid for "
+                  << ladder.size() << " face sizes" << std::endl;
+
+        qint64 pyramid_bytes = 0;
+        for (const QImage& level : pyramid.levels)
+            pyramid_bytes += level.sizeInBytes();
+        finishStage("pyramid", image_in.sizeInBytes(), pyramid_bytes, 0);
+        image_in = QImage();
+
+        bool all_saved = true;
+        for (int edge : ladder) {
+
+            int level = 0;
+            while (level + 1 < static_cast<int>(pyramid.levels.size()) && pyramid.levels[level + 1].width() >= 4 * edge)
+                ++level;
+
+            SourcePyramid rung;
+            rung.levels.assign(pyramid.levels.begin() + level, pyramid.levels.end());
+            rung.views.assign(pyramid.views.begin() + level, pyramid.views.end());
+
+            const QString rung_path = path_no_extension + "_" + QString::number(edge);
+            std::cout << "Face size " << edge << " from pyramid level " << level << ": "
+                      << rung_path.toStdString() << std::endl;
+            if (!convertAndSave(rung.levels[0], edge, &rung, rung_path + ".png", rung_path + texture_extension))
+                all_saved = false;
+        }
+
+        const bool reported = saveReport();
+        return (all_saved && reported) ? 0 : 1;
     }
 
-    // Then save image as a DDS
-    writeCubemapToDDS(image_unfolded.rgbSwapped(), output_dds);
-    std::cout << "Saved Cubemap to DDS: " << output_dds.toStdString() << std::endl;
+    // An unfolded cubemap already has its faces, in any of the layouts, checked when it was loaded
+    int edge = (jpeg_edge > 0) ? jpeg_edge : cubemapEdge(image_in.width(), edge_percent);
+    if (unfolded) {
+        CubemapLayout layout = CubemapLayout::Cross;
+        detectCubemapLayout(image_in.width(), image_in.height(), layout);
+        int columns, rows;
+        cubemapLayoutGrid(layout, columns, rows);
+        edge = image_in.width() / columns;
+    }
+    const bool saved = convertAndSave(std::move(image_in), edge, nullptr, output_png, output_dds);
 
     // Done!
-    return 0;
+    const bool reported = saveReport();
+    return (saved && reported) ? 0 : 1;
 }
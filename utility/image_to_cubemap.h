@@ -25,6 +25,12 @@ THE SOFTWARE.
 #ifndef IMAGE_TO_CUBEMAP_HPP
 #define IMAGE_TO_CUBEMAP_HPP
 
+// C++ and STL includes
+#include <algorithm>
+
+// Qt includes
+#include <QtGlobal>
+
 // Use a more standard PI definition for better portability
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -65,6 +71,15 @@ struct DDS_HEADER {
     quint32 dwReserved2[1];
 };
 
+// DX10 extension header, follows DDS_HEADER when the FourCC is "DX10"
+struct DDS_HEADER_DXT10 {
+    quint32 dxgiFormat;
+    quint32 resourceDimension;
+    quint32 miscFlag;
+    quint32 arraySize;
+    quint32 miscFlags2;
+};
+
 #pragma pack(pop)
 
 /***********************************************************************/
@@ -78,14 +93,36 @@ const quint32 DDSD_HEIGHT = 0x2;
 const quint32 DDSD_WIDTH = 0x4;
 const quint32 DDSD_PITCH = 0x8;
 const quint32 DDSD_PIXELFORMAT = 0x1000;
+const quint32 DDSD_MIPMAPCOUNT = 0x20000;
+const quint32 DDSD_LINEARSIZE = 0x80000;
 
 // DDS_PIXELFORMAT flags
 const quint32 DDPF_RGB = 0x40;
 const quint32 DDPF_ALPHAPIXELS = 0x1;
+const quint32 DDPF_FOURCC = 0x4;
+
+// FourCC codes of the block compressed formats
+const quint32 FOURCC_DXT1 = 0x31545844; // "DXT1"
+const quint32 FOURCC_DXT5 = 0x35545844; // "DXT5"
+const quint32 FOURCC_DX10 = 0x30315844; // "DX10"
+
+// Equi-angular cubemaps are tagged with this FourCC in an otherwise unused
+// dwReserved1 entry of the DDS header, plain cubemaps leave it zero
+const quint32 FOURCC_EAC = 0x20434145; // "EAC "
+const int DDS_PROJECTION_SLOT = 8;
+
+// DX10 header values
+const quint32 DXGI_FORMAT_UNKNOWN = 0;
+const quint32 DXGI_FORMAT_R16G16B16A16_FLOAT = 10;
+const quint32 DXGI_FORMAT_BC6H_UF16 = 95;
+const quint32 DXGI_FORMAT_BC7_UNORM = 98;
+const quint32 DDS_DIMENSION_TEXTURE2D = 3;
+const quint32 DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
 
 // DDSCAPS flags
 const quint32 DDSCAPS_COMPLEX = 0x8;
 const quint32 DDSCAPS_TEXTURE = 0x1000;
+const quint32 DDSCAPS_MIPMAP = 0x400000;
 
 // DDSCAPS2 flags
 const quint32 DDSCAPS2_CUBEMAP = 0x200;
@@ -99,6 +136,24 @@ const quint32 DDSCAPS2_CUBEMAP_ALLFACES = (DDSCAPS2_CUBEMAP_POSITIVEX | DDSCAPS2
                                             DDSCAPS2_CUBEMAP_POSITIVEY | DDSCAPS2_CUBEMAP_NEGATIVEY |
                                             DDSCAPS2_CUBEMAP_POSITIVEZ | DDSCAPS2_CUBEMAP_NEGATIVEZ);
 
+// Face masks have bit f set for face f in DDS order, this one selects every face
+const int CUBEMAP_ALL_FACES = 0x3F;
+
+// Faces are converted in square tiles of this many pixels, small enough that a
+// tile's output and the source rows it samples stay in a core's cache
+const int CUBEMAP_TILE_SIZE = 64;
+
+// Previews are loaded at most this wide, which gives 512 pixel faces, and an
+// embedded DNG preview has to be at least half of that to be used
+const int PREVIEW_WIDTH = 2048;
+const int PREVIEW_MIN_WIDTH = 1024;
+
+// How positions within a cube face map to directions
+enum class CubeProjection {
+    Standard,       // Linear in the tangent of the angle, texels are smallest in the face corners
+    EquiAngular     // Linear in the angle itself (EAC), texels cover about the same solid angle everywhere
+};
+
 // Clamp a value to the given range
 template<typename T>
 T clip(const T& n, const T& lower, const T& upper) {
@@ -0,0 +1,362 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+
+// Zstandard for the level supercompression
+#include <zstd.h>
+
+#include "ktx2_writer.h"
+#include "half_float.h"
+
+// Data format descriptor colour models, primaries, transfer functions and channel flags
+static const quint32 KHR_DF_MODEL_RGBSDA = 1;
+static const quint32 KHR_DF_MODEL_BC1A = 128;
+static const quint32 KHR_DF_MODEL_BC3 = 130;
+static const quint32 KHR_DF_MODEL_BC6H = 133;
+static const quint32 KHR_DF_MODEL_BC7 = 134;
+static const quint32 KHR_DF_PRIMARIES_BT709 = 1;
+static const quint32 KHR_DF_TRANSFER_LINEAR = 1;
+static const quint32 KHR_DF_TRANSFER_SRGB = 2;
+static const quint32 KHR_DF_CHANNEL_ALPHA = 15;
+static const quint32 KHR_DF_SAMPLE_LINEAR = 0x10;
+static const quint32 KHR_DF_SAMPLE_SIGNED = 0x40;
+static const quint32 KHR_DF_SAMPLE_FLOAT = 0x80;
+static const quint32 FLOAT_ONE = 0x3F800000;       // 1.0f
+static const quint32 FLOAT_MINUS_ONE = 0xBF800000; // -1.0f
+
+// One sample of a data format descriptor, bit_length in bits
+struct DfdSample {
+    quint32 channel;
+    quint32 bit_offset;
+    quint32 bit_length;
+    quint32 lower;
+    quint32 upper;
+};
+
+//
+// Build the basic data format descriptor of a format
+//
+// Texel blocks are 4x4 for the block compressed models and 1x1 otherwise,
+// block_bytes is then the size of one block or one pixel.
+//
+static std::vector<quint32> makeDFD(quint32 model, quint32 transfer, bool blocks, quint32 block_bytes,
+                                    const std::vector<DfdSample>& samples) {
+
+    const quint32 block_size = 24 + 16 * static_cast<quint32>(samples.size());
+    const quint32 dimension = blocks ? 3 : 0;
+
+    std::vector<quint32> dfd;
+    dfd.push_back(4 + block_size);                     // dfdTotalSize
+    dfd.push_back(0);                                  // Khronos vendor, basic descriptor type
+    dfd.push_back(2 | (block_size << 16));             // Version 2 and the block size
+    dfd.push_back(model | (KHR_DF_PRIMARIES_BT709 << 8) | (transfer << 16));
+    dfd.push_back(dimension | (dimension << 8));       // Texel block width and height, minus one
+    dfd.push_back(block_bytes);                        // Bytes in plane 0
+    dfd.push_back(0);
+
+    for (const DfdSample& sample : samples) {
+        dfd.push_back(sample.bit_offset | ((sample.bit_length - 1) << 16) | (sample.channel << 24));
+        dfd.push_back(0);
+        dfd.push_back(sample.lower);
+        dfd.push_back(sample.upper);
+    }
+
+    return dfd;
+}
+
+// Fill in the format fields of a KTX2 cubemap
+static void setKTX2Format(Ktx2Cubemap& out, BlockFormat format, bool half) {
+
+    const quint32 alpha = KHR_DF_CHANNEL_ALPHA | KHR_DF_SAMPLE_LINEAR;
+    const quint32 half_channel = KHR_DF_SAMPLE_FLOAT | KHR_DF_SAMPLE_SIGNED;
+
+    out.type_size = 1;
+    switch (format) {
+
+        case BlockFormat::BC1:
+            out.vk_format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            out.dfd = makeDFD(KHR_DF_MODEL_BC1A, KHR_DF_TRANSFER_SRGB, true, 8, { { 0, 0, 64, 0, 0xFFFFFFFF } });
+            break;
+
+        case BlockFormat::BC3:
+            out.vk_format = VK_FORMAT_BC3_SRGB_BLOCK;
+            out.dfd = makeDFD(KHR_DF_MODEL_BC3, KHR_DF_TRANSFER_SRGB, true, 16,
+                              { { alpha, 0, 64, 0, 0xFFFFFFFF }, { 0, 64, 64, 0, 0xFFFFFFFF } });
+            break;
+
+        case BlockFormat::BC7:
+            out.vk_format = VK_FORMAT_BC7_SRGB_BLOCK;
+            out.dfd = makeDFD(KHR_DF_MODEL_BC7, KHR_DF_TRANSFER_SRGB, true, 16, { { 0, 0, 128, 0, 0xFFFFFFFF } });
+            break;
+
+        case BlockFormat::BC6H:
+            out.vk_format = VK_FORMAT_BC6H_UFLOAT_BLOCK;
+            out.dfd = makeDFD(KHR_DF_MODEL_BC6H, KHR_DF_TRANSFER_LINEAR, true, 16,
+                              { { KHR_DF_SAMPLE_FLOAT, 0, 128, 0, FLOAT_ONE } });
+            break;
+
+        case BlockFormat::None:
+            if (half) {
+                out.vk_format = VK_FORMAT_R16G16B16A16_SFLOAT;
+                out.type_size = 2;
+                out.dfd = makeDFD(KHR_DF_MODEL_RGBSDA, KHR_DF_TRANSFER_LINEAR, false, 8,
+                                  { { 0 | half_channel, 0, 16, FLOAT_MINUS_ONE, FLOAT_ONE },
+                                    { 1 | half_channel, 16, 16, FLOAT_MINUS_ONE, FLOAT_ONE },
+                                    { 2 | half_channel, 32, 16, FLOAT_MINUS_ONE, FLOAT_ONE },
+                                    { KHR_DF_CHANNEL_ALPHA | half_channel, 48, 16, FLOAT_MINUS_ONE, FLOAT_ONE } });
+            }
+            else {
+                out.vk_format = VK_FORMAT_R8G8B8A8_SRGB;
+                out.dfd = makeDFD(KHR_DF_MODEL_RGBSDA, KHR_DF_TRANSFER_SRGB, false, 4,
+                                  { { 0, 0, 8, 0, 255 }, { 1, 8, 8, 0, 255 }, { 2, 16, 8, 0, 255 }, { alpha, 24, 8, 0, 255 } });
+            }
+            break;
+    }
+}
+
+// How source rows become KTX2 rows
+enum class Ktx2Rows {
+    Copy,           // Already in the stored format, such as rows of blocks
+    SwapRedBlue,    // 32-bit B, G, R, A pixels to R, G, B, A
+    UnormToHalf     // 16-bit unsigned normalised channels to halfs
+};
+
+// Rows of one level of one face, in pixels or in rows of blocks
+struct Ktx2Source {
+    const uchar *bits;
+    qsizetype    stride;
+    qsizetype    row_bytes;     // Stored bytes per row, the same before and after conversion
+    int          rows;
+};
+
+// A run of rows of one level of one face, compressed into its own frame
+struct Ktx2Chunk {
+    int                 level;
+    int                 face;
+    int                 first_row;
+    int                 rows;
+    std::vector<uchar>  frame;
+};
+
+//
+// Compress every level of the six faces on the pool
+//
+// sources holds each level of each face, level by level.  Every level of every
+// face is cut into chunks of at most KTX2_ZSTD_CHUNK_BYTES, which are converted
+// and compressed independently and then joined back up in order, so each level
+// ends up as the concatenated frames of face 0 to face 5.
+//
+static bool compressLevels(const std::vector<Ktx2Source>& sources, Ktx2Rows conversion, ThreadPool& pool,
+                           int zstd_level, Ktx2Cubemap& out) {
+
+    std::vector<Ktx2Chunk> chunks;
+    out.level_bytes.assign(out.levels, 0);
+
+    for (int level = 0; level < out.levels; ++level) {
+
+        const qsizetype row_bytes = sources[level * 6].row_bytes;
+        const int chunk_rows = static_cast<int>(std::max<qsizetype>(1, KTX2_ZSTD_CHUNK_BYTES / row_bytes));
+
+        for (int face = 0; face < 6; ++face) {
+            const int rows = sources[level * 6 + face].rows;
+            for (int row = 0; row < rows; row += chunk_rows)
+                chunks.push_back({ level, face, row, std::min(chunk_rows, rows - row), std::vector<uchar>() });
+            out.level_bytes[level] += static_cast<quint64>(row_bytes) * rows;
+        }
+    }
+
+    std::atomic<bool> failed(false);
+    pool.parallelFor(static_cast<int>(chunks.size()), [&](int task) {
+
+        Ktx2Chunk& chunk = chunks[task];
+        const Ktx2Source& source = sources[chunk.level * 6 + chunk.face];
+        const qsizetype row_bytes = source.row_bytes;
+
+        // Gather the rows into one tightly packed run in the stored format
+        std::vector<uchar> rows(static_cast<size_t>(row_bytes) * chunk.rows);
+        for (int r = 0; r < chunk.rows; ++r) {
+
+            const uchar* src = source.bits + (chunk.first_row + r) * source.stride;
+            uchar* dst = rows.data() + r * row_bytes;
+
+            if (conversion == Ktx2Rows::SwapRedBlue) {
+                for (qsizetype x = 0; x < row_bytes; x += 4) {
+                    dst[x + 0] = src[x + 2];
+                    dst[x + 1] = src[x + 1];
+                    dst[x + 2] = src[x + 0];
+                    dst[x + 3] = src[x + 3];
+                }
+            }
+            else if (conversion == Ktx2Rows::UnormToHalf) {
+                unormToHalf(reinterpret_cast<const quint16*>(src), static_cast<int>(row_bytes / 2), reinterpret_cast<quint16*>(dst));
+            }
+            else {
+                std::memcpy(dst, src, row_bytes);
+            }
+        }
+
+        chunk.frame.resize(ZSTD_compressBound(rows.size()));
+        const size_t size = ZSTD_compress(chunk.frame.data(), chunk.frame.size(), rows.data(), rows.size(), zstd_level);
+        if (ZSTD_isError(size)) {
+            failed = true;
+            return;
+        }
+        chunk.frame.resize(size);
+    });
+
+    if (failed) {
+        std::cerr << "Zstandard compression failed" << std::endl;
+        return false;
+    }
+
+    // The chunks were made level by level, face by face, so they only need joining up
+    out.level_data.assign(out.levels, std::vector<uchar>());
+    for (const Ktx2Chunk& chunk : chunks) {
+        std::vector<uchar>& data = out.level_data[chunk.level];
+        data.insert(data.end(), chunk.frame.begin(), chunk.frame.end());
+    }
+
+    return true;
+}
+
+bool encodeCubemapKTX2(const FaceViews& faces, const CubemapMips* mips, ThreadPool& pool, Ktx2Cubemap& out, int zstd_level) {
+
+    const bool half = (faces.depth == 64);
+    const int pixel_bytes = faces.depth / 8;
+
+    setKTX2Format(out, BlockFormat::None, half);
+    out.edge = faces.edge;
+    out.levels = mips ? mips->levels : 1;
+
+    // Level 0 is in the faces' image, the smaller levels are packed in each face's mip chain
+    std::vector<Ktx2Source> sources(static_cast<size_t>(out.levels) * 6);
+    for (int face = 0; face < 6; ++face) {
+
+        sources[face] = { faces.bits[face], faces.stride, static_cast<qsizetype>(faces.edge) * pixel_bytes, faces.edge };
+
+        const uchar* level_bits = mips ? mips->faces[face].data() : nullptr;
+        for (int level = 1; level < out.levels; ++level) {
+            const int edge = mipLevelEdge(faces.edge, level);
+            const qsizetype stride = static_cast<qsizetype>(edge) * pixel_bytes;
+            sources[level * 6 + face] = { level_bits, stride, stride, edge };
+            level_bits += stride * edge;
+        }
+    }
+
+    return compressLevels(sources, half ? Ktx2Rows::UnormToHalf : Ktx2Rows::SwapRedBlue, pool, zstd_level, out);
+}
+
+bool encodeCompressedCubemapKTX2(const CompressedCubemap& cubemap, ThreadPool& pool, Ktx2Cubemap& out, int zstd_level) {
+
+    setKTX2Format(out, cubemap.format, false);
+    out.edge = cubemap.edge;
+    out.levels = cubemap.levels;
+
+    // The DDS payload is face by face, each followed by its levels, every level rows of blocks
+    const int block_bytes = blockBytes(cubemap.format);
+    std::vector<Ktx2Source> sources(static_cast<size_t>(out.levels) * 6);
+    const uchar* bits = cubemap.data.data();
+    for (int face = 0; face < 6; ++face) {
+        for (int level = 0; level < out.levels; ++level) {
+            const int edge = mipLevelEdge(cubemap.edge, level);
+            const int blocks = std::max(1, (edge + 3) / 4);
+            const qsizetype row_bytes = static_cast<qsizetype>(blocks) * block_bytes;
+            sources[level * 6 + face] = { bits, row_bytes, row_bytes, blocks };
+            bits += compressedLevelBytes(edge, edge, cubemap.format);
+        }
+    }
+
+    return compressLevels(sources, Ktx2Rows::Copy, pool, zstd_level, out);
+}
+
+// Append a key/value entry to the key/value data, padded to 4 bytes
+static void addKeyValue(std::string& kvd, const std::string& key, const std::string& value) {
+
+    const quint32 length = static_cast<quint32>(key.size() + 1 + value.size() + 1);
+    kvd.append(reinterpret_cast<const char*>(&length), sizeof(quint32));
+    kvd.append(key).push_back('\0');
+    kvd.append(value).push_back('\0');
+    kvd.resize((kvd.size() + 3) & ~static_cast<size_t>(3), '\0');
+}
+
+bool writeKTX2(const Ktx2Cubemap& cubemap, const QString& save_file_path, CubeProjection projection) {
+
+    std::ofstream file(save_file_path.toStdString(), std::ios::out | std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not open file for writing: " << save_file_path.toStdString() << std::endl;
+        return false;
+    }
+
+    // Keys have to be sorted, equi-angular faces are marked with a key of our own
+    std::string kvd;
+    addKeyValue(kvd, "KTXorientation", "rd");
+    addKeyValue(kvd, "KTXwriter", "image_to_cubemap");
+    if (projection == CubeProjection::EquiAngular)
+        addKeyValue(kvd, "image_to_cubemap.projection", "eac");
+
+    const quint32 dfd_bytes = static_cast<quint32>(cubemap.dfd.size() * sizeof(quint32));
+
+    KTX2_HEADER header = {};
+    header.vkFormat = cubemap.vk_format;
+    header.typeSize = cubemap.type_size;
+    header.pixelWidth = cubemap.edge;
+    header.pixelHeight = cubemap.edge;
+    header.faceCount = 6;
+    header.levelCount = cubemap.levels;
+    header.supercompressionScheme = KTX2_SUPERCOMPRESSION_ZSTD;
+    header.dfdByteOffset = static_cast<quint32>(sizeof(KTX2_IDENTIFIER) + sizeof(KTX2_HEADER) + cubemap.levels * sizeof(KTX2_LEVEL));
+    header.dfdByteLength = dfd_bytes;
+    header.kvdByteOffset = header.dfdByteOffset + dfd_bytes;
+    header.kvdByteLength = static_cast<quint32>(kvd.size());
+
+    // Supercompressed levels need no alignment, and go in smallest first
+    std::vector<KTX2_LEVEL> index(cubemap.levels);
+    quint64 offset = header.kvdByteOffset + header.kvdByteLength;
+    for (int level = cubemap.levels - 1; level >= 0; --level) {
+        index[level].byteOffset = offset;
+        index[level].byteLength = cubemap.level_data[level].size();
+        index[level].uncompressedByteLength = cubemap.level_bytes[level];
+        offset += index[level].byteLength;
+    }
+
+    file.write(reinterpret_cast<const char*>(KTX2_IDENTIFIER), sizeof(KTX2_IDENTIFIER));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(KTX2_HEADER));
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(KTX2_LEVEL)));
+    file.write(reinterpret_cast<const char*>(cubemap.dfd.data()), dfd_bytes);
+    file.write(kvd.data(), static_cast<std::streamsize>(kvd.size()));
+
+    for (int level = cubemap.levels - 1; level >= 0; --level)
+        file.write(reinterpret_cast<const char*>(cubemap.level_data[level].data()), static_cast<std::streamsize>(cubemap.level_data[level].size()));
+
+    file.close();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,122 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef KTX2_WRITER_HPP
+#define KTX2_WRITER_HPP
+
+// C++ and STL includes
+#include <vector>
+
+// Qt includes
+#include <QtGlobal>
+#include <QString>
+
+#include "image_to_cubemap.h"
+#include "thread_pool.h"
+#include "cubemap_convert.h"
+#include "mipmap.h"
+#include "block_compress.h"
+
+/***********************************************************************/
+
+// Use a pragma to ensure the structures are tightly packed
+#pragma pack(push, 4)
+
+// KTX2 header, follows the 12 byte identifier
+struct KTX2_HEADER {
+    quint32 vkFormat;
+    quint32 typeSize;
+    quint32 pixelWidth;
+    quint32 pixelHeight;
+    quint32 pixelDepth;
+    quint32 layerCount;
+    quint32 faceCount;
+    quint32 levelCount;
+    quint32 supercompressionScheme;
+    quint32 dfdByteOffset;
+    quint32 dfdByteLength;
+    quint32 kvdByteOffset;
+    quint32 kvdByteLength;
+    quint64 sgdByteOffset;
+    quint64 sgdByteLength;
+};
+
+// One entry of the level index that follows the header, level 0 first
+struct KTX2_LEVEL {
+    quint64 byteOffset;
+    quint64 byteLength;
+    quint64 uncompressedByteLength;
+};
+
+#pragma pack(pop)
+
+/***********************************************************************/
+
+// KTX2 constants
+const uchar KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+const quint32 KTX2_SUPERCOMPRESSION_ZSTD = 2;
+
+// Vulkan formats of the pixel formats the converter writes, colour is sRGB
+const quint32 VK_FORMAT_R8G8B8A8_SRGB = 43;
+const quint32 VK_FORMAT_R16G16B16A16_SFLOAT = 97;
+const quint32 VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+const quint32 VK_FORMAT_BC3_SRGB_BLOCK = 138;
+const quint32 VK_FORMAT_BC6H_UFLOAT_BLOCK = 143;
+const quint32 VK_FORMAT_BC7_SRGB_BLOCK = 146;
+
+// Zstandard level used unless another one is asked for, and how much of a
+// level goes into each separately compressed frame
+const int KTX2_ZSTD_LEVEL = 9;
+const qsizetype KTX2_ZSTD_CHUNK_BYTES = 1 << 20;
+
+//
+// A cubemap ready to be written as a KTX2 file
+//
+// Each level holds all six faces in KTX2 order (+X, -X, +Y, -Y, +Z, -Z) as one
+// or more concatenated Zstandard frames, which a single ZSTD_decompress() call
+// reads back as the whole level.  Splitting levels into frames is what lets
+// them be compressed on every core.
+//
+struct Ktx2Cubemap {
+    quint32                          vk_format = VK_FORMAT_R8G8B8A8_SRGB;
+    quint32                          type_size = 1;
+    int                              edge = 0;
+    int                              levels = 1;
+    std::vector<quint32>             dfd;            // Data format descriptor, starting with its total size
+    std::vector<std::vector<uchar>>  level_data;     // Compressed levels, level 0 first
+    std::vector<quint64>             level_bytes;    // Uncompressed size of each level
+};
+
+// Compress 32-bit BGRA (or RGBA64) faces and their mips, stored as RGBA8 (or RGBA16F) levels, false on failure
+bool encodeCubemapKTX2(const FaceViews& faces, const CubemapMips* mips, ThreadPool& pool, Ktx2Cubemap& out,
+                       int zstd_level = KTX2_ZSTD_LEVEL);
+
+// Compress the levels of a block compressed cubemap as they are
+bool encodeCompressedCubemapKTX2(const CompressedCubemap& cubemap, ThreadPool& pool, Ktx2Cubemap& out,
+                                 int zstd_level = KTX2_ZSTD_LEVEL);
+
+// Write a cubemap as a KTX2 file, the smallest levels come first so a client can fetch them first
+bool writeKTX2(const Ktx2Cubemap& cubemap, const QString& save_file_path, CubeProjection projection = CubeProjection::Standard);
+
+#endif // KTX2_WRITER_HPP
@@ -0,0 +1,193 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+
+// SSE2 is part of every x86-64 CPU, so the box filter needs no runtime dispatch
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define MIPMAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "mipmap.h"
+
+int mipLevelCount(int edge) {
+
+    int levels = 1;
+    while (edge > 1) {
+        edge >>= 1;
+        ++levels;
+    }
+    return levels;
+}
+
+//
+// Average the 2x2 blocks of two source rows into one destination row
+//
+// Odd widths drop the last source column, a width of 1 averages the column
+// with itself.  Each channel is rounded as (a + b + c + d + 2) / 4, the SSE2
+// loop below gives exactly the same bytes.
+//
+static void downsampleRow(const uchar* row0, const uchar* row1, int width, uchar* dst, int dst_width) {
+
+    int x = 0;
+
+#ifdef MIPMAP_SSE2
+    if (width >= 2) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+
+        // Four destination pixels from eight source pixels of both rows
+        for (; x + 4 <= dst_width; x += 4) {
+            __m128i result[2];
+            for (int half = 0; half < 2; ++half) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + (2 * x + 4 * half) * 4));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + (2 * x + 4 * half) * 4));
+
+                // Vertical sums of pixels 0, 1 and pixels 2, 3 as 16-bit channels
+                const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+                // Then the horizontal pairs, 0 + 1 and 2 + 3
+                const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+                result[half] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(result[0], result[1]));
+        }
+    }
+#endif
+
+    for (; x < dst_width; ++x) {
+        const int x0 = 2 * x;
+        const int x1 = std::min(x0 + 1, width - 1);
+        for (int c = 0; c < 4; ++c) {
+            const int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+            dst[x * 4 + c] = static_cast<uchar>((sum + 2) >> 2);
+        }
+    }
+}
+
+//
+// The same for RGBA64 rows, 16-bit channels are summed in 32-bit lanes
+//
+static void downsampleRow64(const quint16* row0, const quint16* row1, int width, quint16* dst, int dst_width) {
+
+    int x = 0;
+
+#ifdef MIPMAP_SSE2
+    if (width >= 2) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi32(2);
+        const __m128i offset = _mm_set1_epi32(32768);
+        const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+
+        // Two destination pixels from four source pixels of both rows
+        for (; x + 2 <= dst_width; x += 2) {
+            __m128i result[2];
+            for (int half = 0; half < 2; ++half) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + (2 * x + 2 * half) * 4));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + (2 * x + 2 * half) * 4));
+
+                const __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(a, zero), _mm_unpackhi_epi16(a, zero)),
+                                                  _mm_add_epi32(_mm_unpacklo_epi16(b, zero), _mm_unpackhi_epi16(b, zero)));
+
+                // Offset by -32768 so the signed pack below can't saturate
+                result[half] = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(sum, two), 2), offset);
+            }
+            const __m128i packed = _mm_xor_si128(_mm_packs_epi32(result[0], result[1]), flip);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), packed);
+        }
+    }
+#endif
+
+    for (; x < dst_width; ++x) {
+        const int x0 = 2 * x;
+        const int x1 = std::min(x0 + 1, width - 1);
+        for (int c = 0; c < 4; ++c) {
+            const quint32 sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+            dst[x * 4 + c] = static_cast<quint16>((sum + 2) >> 2);
+        }
+    }
+}
+
+void downsampleBox(const uchar* src, qsizetype src_stride, int width, int height, uchar* dst, qsizetype dst_stride, int depth) {
+
+    const int dst_width = std::max(1, width / 2);
+    const int dst_height = std::max(1, height / 2);
+
+    for (int y = 0; y < dst_height; ++y) {
+        const int y0 = 2 * y;
+        const int y1 = std::min(y0 + 1, height - 1);
+
+        if (depth == 64)
+            downsampleRow64(reinterpret_cast<const quint16*>(src + y0 * src_stride), reinterpret_cast<const quint16*>(src + y1 * src_stride),
+                            width, reinterpret_cast<quint16*>(dst + y * dst_stride), dst_width);
+        else
+            downsampleRow(src + y0 * src_stride, src + y1 * src_stride, width, dst + y * dst_stride, dst_width);
+    }
+}
+
+//
+// Build levels 1 .. levels - 1 of one face, each level is made from the one before
+//
+static void buildFaceChain(const uchar* face, qsizetype stride, int edge, int levels, int depth, std::vector<uchar>& chain) {
+
+    const int pixel_bytes = depth / 8;
+
+    qsizetype chain_bytes = 0;
+    for (int level = 1; level < levels; ++level) {
+        const qsizetype level_edge = mipLevelEdge(edge, level);
+        chain_bytes += level_edge * level_edge * pixel_bytes;
+    }
+    chain.resize(chain_bytes);
+
+    const uchar* src = face;
+    qsizetype src_stride = stride;
+    uchar* dst = chain.data();
+
+    for (int level = 1; level < levels; ++level) {
+        const int src_edge = mipLevelEdge(edge, level - 1);
+        const int dst_edge = mipLevelEdge(edge, level);
+
+        downsampleBox(src, src_stride, src_edge, src_edge, dst, static_cast<qsizetype>(dst_edge) * pixel_bytes, depth);
+
+        src = dst;
+        src_stride = static_cast<qsizetype>(dst_edge) * pixel_bytes;
+        dst += src_stride * dst_edge;
+    }
+}
+
+void buildCubemapMips(const FaceViews& faces, ThreadPool& pool, CubemapMips& mips, int face_mask) {
+
+    mips.edge = faces.edge;
+    mips.levels = mipLevelCount(faces.edge);
+    mips.depth = faces.depth;
+
+    // Each face only reads its own pixels, so the faces are independent tasks
+    pool.parallelFor(6, [&](int face) {
+        if (face_mask & (1 << face))
+            buildFaceChain(faces.bits[face], faces.stride, faces.edge, mips.levels, faces.depth, mips.faces[face]);
+    });
+}
@@ -0,0 +1,69 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef MIPMAP_HPP
+#define MIPMAP_HPP
+
+// C++ and STL includes
+#include <vector>
+
+// Qt includes
+#include <QtGlobal>
+#include <QImage>
+
+#include "image_to_cubemap.h"
+#include "thread_pool.h"
+#include "cubemap_convert.h"
+
+//
+// The smaller mip levels of a cubemap
+//
+// Level 0 stays in the image the faces were converted into, so only levels
+// 1 .. levels - 1 are kept here, packed tightly one after the other per face
+// in the pixel format of the faces: B, G, R, A bytes like the DDS file uses,
+// or 16-bit R, G, B, A channels for RGBA64 faces.
+//
+struct CubemapMips {
+    int                 edge = 0;
+    int                 levels = 1;     // Including the full size level 0
+    int                 depth = 32;     // Bits per pixel, 32 or 64
+    std::vector<uchar>  faces[6];
+};
+
+// Number of levels in a full mip chain down to 1x1
+int mipLevelCount(int edge);
+
+// Edge length of a mip level
+inline int mipLevelEdge(int edge, int level) {
+    return qMax(1, edge >> level);
+}
+
+// Halve a 32-bit (or 64-bit RGBA64) image with a 2x2 box filter, the destination is max(1, w / 2) x max(1, h / 2)
+void downsampleBox(const uchar* src, qsizetype src_stride, int width, int height, uchar* dst, qsizetype dst_stride, int depth = 32);
+
+// Build the mip chains of the six faces, one face per task.  Faces left out of
+// face_mask keep an empty chain.
+void buildCubemapMips(const FaceViews& faces, ThreadPool& pool, CubemapMips& mips, int face_mask = CUBEMAP_ALL_FACES);
+
+#endif // MIPMAP_HPP
@@ -0,0 +1,331 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// zlib, which libpng is built on
+#include <zlib.h>
+
+// Qt includes
+#include <QFile>
+
+#include "png_writer.h"
+#include "thread_pool.h"
+
+// Every PNG file starts with these bytes
+static const uchar PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+// The filter type byte in front of every row
+enum RowFilter { ROW_FILTER_NONE = 0, ROW_FILTER_SUB, ROW_FILTER_UP, ROW_FILTER_AVERAGE, ROW_FILTER_PAETH, ROW_FILTER_COUNT };
+
+// deflate looks back at most this far, so this much of a strip primes the next one
+static const int DEFLATE_WINDOW_BYTES = 32768;
+
+//
+// One strip of rows, filtered and deflated as a raw deflate stream that ends on
+// a byte boundary (or, for the last strip, with the final block)
+//
+struct PngStrip {
+    std::vector<uchar>  data;
+    uLong               adler = 1;      // Adler-32 of the filtered rows, combined into the zlib trailer
+    qint64              raw_bytes = 0;
+    bool                ok = false;
+};
+
+static void storeBigEndian(uchar* out, quint32 value) {
+    out[0] = static_cast<uchar>(value >> 24);
+    out[1] = static_cast<uchar>(value >> 16);
+    out[2] = static_cast<uchar>(value >> 8);
+    out[3] = static_cast<uchar>(value);
+}
+
+// Pack row y of an RGB32 or RGBA64 image into PNG's RGB byte order, 16-bit samples big endian
+static void packRow(const QImage& image, int y, bool wide, uchar* out) {
+
+    const int width = image.width();
+
+    if (wide) {
+        const quint16* in = reinterpret_cast<const quint16*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x, in += 4) {
+            for (int c = 0; c < 3; ++c) {
+                *out++ = static_cast<uchar>(in[c] >> 8);
+                *out++ = static_cast<uchar>(in[c]);
+            }
+        }
+        return;
+    }
+
+    const QRgb* in = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+    for (int x = 0; x < width; ++x) {
+        *out++ = static_cast<uchar>(qRed(in[x]));
+        *out++ = static_cast<uchar>(qGreen(in[x]));
+        *out++ = static_cast<uchar>(qBlue(in[x]));
+    }
+}
+
+static inline int paethPredictor(int a, int b, int c) {
+
+    const int pa = std::abs(b - c);
+    const int pb = std::abs(a - c);
+    const int pc = std::abs(a + b - 2 * c);
+    const int bc = (pb <= pc) ? b : c;
+    return (pa <= pb && pa <= pc) ? a : bc;
+}
+
+// Apply one PNG filter to bytes begin..end - 1 of a packed row, above is the packed row
+// before it (all zero for the first row).  Only the first pixel has nothing to its left,
+// the rest of the row runs without that check.
+static void filterRow(int filter, const uchar* row, const uchar* above, int begin, int end, int bpp, uchar* out) {
+
+    const int left = std::min(std::max(begin, bpp), end);
+
+    switch (filter) {
+    case ROW_FILTER_NONE:
+        memcpy(out + begin, row + begin, end - begin);
+        break;
+    case ROW_FILTER_SUB:
+        for (int i = begin; i < left; ++i)
+            out[i] = row[i];
+        for (int i = left; i < end; ++i)
+            out[i] = static_cast<uchar>(row[i] - row[i - bpp]);
+        break;
+    case ROW_FILTER_UP:
+        for (int i = begin; i < end; ++i)
+            out[i] = static_cast<uchar>(row[i] - above[i]);
+        break;
+    case ROW_FILTER_AVERAGE:
+        for (int i = begin; i < left; ++i)
+            out[i] = static_cast<uchar>(row[i] - (above[i] >> 1));
+        for (int i = left; i < end; ++i)
+            out[i] = static_cast<uchar>(row[i] - ((row[i - bpp] + above[i]) >> 1));
+        break;
+    default:
+        for (int i = begin; i < left; ++i)
+            out[i] = static_cast<uchar>(row[i] - above[i]);
+        for (int i = left; i < end; ++i)
+            out[i] = static_cast<uchar>(row[i] - paethPredictor(row[i - bpp], above[i], above[i - bpp]));
+        break;
+    }
+}
+
+// Bytes filtered between checks of whether a filter has already lost to a better one
+static const int FILTER_COST_BLOCK = 1024;
+
+// The usual filter heuristic, the sum of the filtered bytes read as signed values.
+// Filtering stops early once the sum reaches limit, that filter can't be the best.
+static quint64 filterRowCost(int filter, const uchar* row, const uchar* above, int bytes, int bpp, uchar* out, quint64 limit) {
+
+    quint64 cost = 0;
+    for (int begin = 0; begin < bytes && cost < limit; begin += FILTER_COST_BLOCK) {
+
+        const int end = std::min(begin + FILTER_COST_BLOCK, bytes);
+        filterRow(filter, row, above, begin, end, bpp, out);
+
+        unsigned int block_cost = 0;
+        for (int i = begin; i < end; ++i)
+            block_cost += (out[i] < 128) ? out[i] : 256 - out[i];
+        cost += block_cost;
+    }
+    return cost;
+}
+
+// Filter rows first..last - 1 of the image into PNG's filter byte + row layout
+static void filterRows(const QImage& image, bool wide, int bpp, int zlib_level, int first, int last, uchar* out) {
+
+    const int row_bytes = image.width() * bpp;
+    std::vector<uchar> above(row_bytes, 0);
+    std::vector<uchar> row(row_bytes);
+    std::vector<uchar> candidate(row_bytes);
+    std::vector<uchar> best(row_bytes);
+
+    if (first > 0)
+        packRow(image, first - 1, wide, above.data());
+
+    for (int y = first; y < last; ++y, out += row_bytes + 1) {
+
+        packRow(image, y, wide, row.data());
+
+        // Stored data doesn't get any smaller by filtering it
+        if (zlib_level == 0) {
+            out[0] = ROW_FILTER_NONE;
+            memcpy(out + 1, row.data(), row_bytes);
+        }
+        else {
+            quint64 best_cost = ~0ull;
+            for (int filter = ROW_FILTER_NONE; filter < ROW_FILTER_COUNT; ++filter) {
+                const quint64 cost = filterRowCost(filter, row.data(), above.data(), row_bytes, bpp, candidate.data(), best_cost);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    out[0] = static_cast<uchar>(filter);
+                    std::swap(best, candidate);
+                }
+            }
+            memcpy(out + 1, best.data(), row_bytes);
+        }
+
+        std::swap(above, row);
+    }
+}
+
+// Filter and deflate one strip of rows, primed with the end of the strip before it
+static void compressStrip(const QImage& image, bool wide, int bpp, int zlib_level, int first, int last, PngStrip& strip) {
+
+    const qsizetype filtered_row_bytes = static_cast<qsizetype>(image.width()) * bpp + 1;
+
+    // The rows that make up the preset dictionary are filtered again here, rather
+    // than waiting for the task that owns them
+    const int primer_rows = std::min<qsizetype>(first, (DEFLATE_WINDOW_BYTES + filtered_row_bytes - 1) / filtered_row_bytes);
+    const qsizetype primer_bytes = primer_rows * filtered_row_bytes;
+
+    std::vector<uchar> filtered((last - first + primer_rows) * filtered_row_bytes);
+    filterRows(image, wide, bpp, zlib_level, first - primer_rows, last, filtered.data());
+
+    const uchar* input = filtered.data() + primer_bytes;
+    strip.raw_bytes = (last - first) * filtered_row_bytes;
+    strip.adler = adler32(adler32(0, Z_NULL, 0), input, static_cast<uInt>(strip.raw_bytes));
+
+    // A raw deflate stream, the zlib header and trailer are written around the strips
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, zlib_level, Z_DEFLATED, -15, 8, zlib_level > 0 ? Z_FILTERED : Z_DEFAULT_STRATEGY) != Z_OK)
+        return;
+
+    if (primer_bytes > 0) {
+        const qsizetype dictionary_bytes = std::min<qsizetype>(primer_bytes, DEFLATE_WINDOW_BYTES);
+        deflateSetDictionary(&stream, input - dictionary_bytes, static_cast<uInt>(dictionary_bytes));
+    }
+
+    // Room for the worst case plus the empty block a sync flush ends with
+    strip.data.resize(deflateBound(&stream, static_cast<uLong>(strip.raw_bytes)) + 64);
+    stream.next_in = const_cast<uchar*>(input);
+    stream.avail_in = static_cast<uInt>(strip.raw_bytes);
+    stream.next_out = strip.data.data();
+    stream.avail_out = static_cast<uInt>(strip.data.size());
+
+    // Every strip but the last ends on a byte boundary so the next one can follow it
+    const bool final_strip = (last == image.height());
+    const int status = deflate(&stream, final_strip ? Z_FINISH : Z_SYNC_FLUSH);
+    strip.ok = final_strip ? (status == Z_STREAM_END) : (status == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
+
+    strip.data.resize(stream.total_out);
+    strip.data.shrink_to_fit();
+    deflateEnd(&stream);
+}
+
+// Write a chunk: its length, type, data and the CRC of type and data
+static bool writeChunk(QFile& file, const char* type, const uchar* data, quint32 bytes) {
+
+    uchar length[4];
+    storeBigEndian(length, bytes);
+
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+    if (bytes > 0)
+        crc = crc32(crc, data, bytes);
+    uchar crc_bytes[4];
+    storeBigEndian(crc_bytes, static_cast<quint32>(crc));
+
+    return file.write(reinterpret_cast<const char*>(length), 4) == 4 &&
+           file.write(type, 4) == 4 &&
+           file.write(reinterpret_cast<const char*>(data), bytes) == static_cast<qint64>(bytes) &&
+           file.write(reinterpret_cast<const char*>(crc_bytes), 4) == 4;
+}
+
+bool writePNG(const QImage& image_in, const QString& save_file_path, int zlib_level, ThreadPool* pool) {
+
+    if (image_in.isNull())
+        return false;
+
+    const bool wide = image_in.format() == QImage::Format_RGBA64 || image_in.format() == QImage::Format_RGBX64;
+    const QImage image = (wide || image_in.format() == QImage::Format_RGB32) ? image_in : image_in.convertToFormat(QImage::Format_RGB32);
+    zlib_level = std::clamp(zlib_level, 0, 9);
+
+    const int bpp = wide ? 6 : 3;
+    const qsizetype row_bytes = static_cast<qsizetype>(image.width()) * bpp;
+    const int rows_per_strip = static_cast<int>(std::max<qsizetype>(1, PNG_STRIP_BYTES / row_bytes));
+    const int strip_count = (image.height() + rows_per_strip - 1) / rows_per_strip;
+
+    std::vector<PngStrip> strips(strip_count);
+    const std::function<void(int)> task = [&](int s) {
+        const int first = s * rows_per_strip;
+        compressStrip(image, wide, bpp, zlib_level, first, std::min(first + rows_per_strip, image.height()), strips[s]);
+    };
+    if (pool)
+        pool->parallelFor(strip_count, task);
+    else
+        for (int s = 0; s < strip_count; ++s)
+            task(s);
+
+    // The strips join into one zlib stream, its trailer is the Adler-32 of all of them
+    uLong adler = strips[0].adler;
+    for (int s = 0; s < strip_count; ++s) {
+        if (!strips[s].ok) {
+            std::cerr << "Failed to compress PNG: " << save_file_path.toStdString() << std::endl;
+            return false;
+        }
+        if (s > 0)
+            adler = adler32_combine(adler, strips[s].adler, strips[s].raw_bytes);
+    }
+
+    // A 32K window, and the compression level the way zlib itself records it
+    const int zlib_flevel = (zlib_level < 2) ? 0 : (zlib_level < 6) ? 1 : (zlib_level == 6) ? 2 : 3;
+    const uchar zlib_header[2] = { 0x78, static_cast<uchar>((zlib_flevel << 6) + (31 - ((0x78 << 8) + (zlib_flevel << 6)) % 31) % 31) };
+    strips.front().data.insert(strips.front().data.begin(), zlib_header, zlib_header + 2);
+
+    uchar zlib_trailer[4];
+    storeBigEndian(zlib_trailer, static_cast<quint32>(adler));
+    strips.back().data.insert(strips.back().data.end(), zlib_trailer, zlib_trailer + 4);
+
+    // 8 or 16 bits per sample, truecolour, deflate, adaptive filtering, not interlaced
+    uchar header[13];
+    storeBigEndian(header, static_cast<quint32>(image.width()));
+    storeBigEndian(header + 4, static_cast<quint32>(image.height()));
+    header[8] = wide ? 16 : 8;
+    header[9] = 2;
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+
+    QFile file(save_file_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cerr << "Could not open file for writing: " << save_file_path.toStdString() << std::endl;
+        return false;
+    }
+
+    // Each strip goes into its own IDAT chunk
+    bool written = file.write(reinterpret_cast<const char*>(PNG_SIGNATURE), sizeof(PNG_SIGNATURE)) == sizeof(PNG_SIGNATURE) &&
+                   writeChunk(file, "IHDR", header, sizeof(header));
+    for (const PngStrip& strip : strips)
+        written = written && writeChunk(file, "IDAT", strip.data.data(), static_cast<quint32>(strip.data.size()));
+    written = written && writeChunk(file, "IEND", nullptr, 0);
+
+    file.close();
+    if (!written)
+        std::cerr << "Failed to write PNG: " << save_file_path.toStdString() << std::endl;
+    return written;
+}
@@ -0,0 +1,54 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef PNG_WRITER_HPP
+#define PNG_WRITER_HPP
+
+// Qt includes
+#include <QImage>
+#include <QString>
+
+class ThreadPool;
+
+// zlib level used for PNGs unless another one is asked for, the same as Qt's default
+const int PNG_ZLIB_LEVEL = 6;
+
+// About how many bytes of pixel rows go into each separately deflated strip
+const qsizetype PNG_STRIP_BYTES = 1 << 20;
+
+//
+// Write an image as a PNG, compressing strips of rows on every core
+//
+// RGB32 images are written as 8-bit RGB, RGBA64 (and RGBX64) ones as 16-bit
+// RGB, anything else is converted to RGB32 first.  Each strip of rows is
+// filtered and deflated on its own, primed with the last 32 KB of the strip
+// before it so little compression is lost, and the strips are joined into
+// one zlib stream like pigz does.  zlib_level goes from 0 (stored) to 9.
+// Without a pool the strips are compressed one after another on the calling
+// thread, which may then be any thread.
+//
+bool writePNG(const QImage& image, const QString& save_file_path, int zlib_level = PNG_ZLIB_LEVEL,
+              ThreadPool* pool = nullptr);
+
+#endif // PNG_WRITER_HPP
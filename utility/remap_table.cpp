@@ -0,0 +1,301 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <iostream>
+
+// Qt includes
+#include <QDir>
+#include <QSaveFile>
+
+#include "remap_table.h"
+#include "cubemap_convert.h"
+
+RemapTable::~RemapTable() {
+    clear();
+}
+
+void RemapTable::clear(void) {
+
+    if (m_mapping) {
+        m_file.unmap(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file.isOpen())
+        m_file.close();
+
+    m_storage.clear();
+    m_storage.shrink_to_fit();
+    m_points = nullptr;
+    m_input_width = m_input_height = m_edge = 0;
+    m_layout = REMAP_LAYOUT_CROSS;
+}
+
+//
+// Building a table works out the angles of as few texels as possible
+//
+// Mirroring a texel across the centre column of a face negates its x (or z),
+// mirroring it across the centre row negates y, and the top and bottom faces
+// and the four side faces reach the same directions up to those signs.  As
+// atan2 is odd in its first argument and hypot ignores the order and signs of
+// its arguments, the angles one texel gets are exactly the ones
+// sourcePosition() works out for the others, so a table comes out the same bit
+// for bit.  Only mirrors whose coordinates are exactly negated floats are used.
+// Four atan2 calls cover up to 24 texels, rather than two for every texel, and
+// the halves of the sample points are shared the same way.
+//
+// The turns of the cube that move the y axis (the other two thirds of its 48
+// symmetries) change the equirectangular angles in ways only more trig can
+// follow, so they aren't used.
+//
+void RemapTable::build(int inW, int inH, int edge, ThreadPool& pool, CubeProjection projection) {
+
+    clear();
+
+    m_storage.resize(static_cast<size_t>(6) * edge * edge);
+    SamplePoint* points = m_storage.data();
+
+    // Coordinates across a face, the same for every face: x = a and y = -b on the front face
+    std::vector<float> column_x(edge), row_y(edge);
+    for (int k = 0; k < edge; ++k) {
+        float x, y, z;
+        outImgToXYZ(k, k, 4, edge, x, y, z, projection);
+        column_x[k] = x;
+        row_y[k] = y;
+    }
+
+    // The column (or row) mirroring each one across the face centre, when its
+    // coordinate is exactly the negated one, otherwise -1
+    auto findMirrors = [edge](const std::vector<float>& coordinates) {
+        std::vector<int> mirrors(edge, -1);
+        for (int k = 1; k < edge; ++k)
+            if (edge - k != k && coordinates[edge - k] == -coordinates[k])
+                mirrors[k] = edge - k;
+        return mirrors;
+    };
+    const std::vector<int> column_mirror = findMirrors(column_x);
+    const std::vector<int> row_mirror = findMirrors(row_y);
+
+    // makeSamplePoint() works out the column and the row of a point independently,
+    // so the halves are found once for each longitude and latitude and then joined
+    auto columnHalf = [&](float theta) {
+        return makeSamplePoint(longitudeToSource(theta, inW), 0.0f, inW, inH);
+    };
+    auto rowHalf = [&](float phi) {
+        return makeSamplePoint(0.0f, latitudeToSource(phi, inH), inW, inH);
+    };
+    auto store = [&](int face, int i, int j, const SamplePoint& column, const SamplePoint& row) {
+        SamplePoint& point = points[(static_cast<qsizetype>(face) * edge + j) * edge + i];
+        point.u = column.u;
+        point.fu = column.fu;
+        point.v = row.v;
+        point.fv = row.fv;
+    };
+
+    // The longitude of a side face texel only depends on its column
+    const int side_faces[4] = { 0, 1, 4, 5 };
+    std::vector<SamplePoint> side_columns(4 * static_cast<size_t>(edge));
+    for (int side = 0; side < 4; ++side) {
+        for (int i = 0; i < edge; ++i) {
+            float x, y, z;
+            outImgToXYZ(i, 0, side_faces[side], edge, x, y, z, projection);
+            side_columns[side * edge + i] = columnHalf(directionLongitude(x, z));
+        }
+    }
+
+    // Rows are worked out in mirrored pairs, the first row of each pair fills both
+    std::vector<int> first_rows;
+    for (int j = 0; j < edge; ++j)
+        if (row_mirror[j] < 0 || row_mirror[j] > j)
+            first_rows.push_back(j);
+
+    pool.parallelFor(static_cast<int>(first_rows.size()), [&](int index) {
+
+        const int j = first_rows[index];
+        const int mj = row_mirror[j];
+
+        for (int i = 0; i < edge; ++i) {
+
+            const int mi = column_mirror[i];
+            if (mi >= 0 && mi < i)
+                continue;
+
+            // A side face texel's latitude is the same on all four side faces,
+            // and the same in the mirrored column, as hypot(x, z) is the same
+            float x, y, z;
+            outImgToXYZ(i, j, 4, edge, x, y, z, projection);
+            const float side_phi = directionLatitude(x, y, z);
+            const SamplePoint side_row = rowHalf(side_phi);
+            const SamplePoint side_mirror_row = (mj >= 0) ? rowHalf(-side_phi) : side_row;
+
+            for (int side = 0; side < 4; ++side) {
+                const int face = side_faces[side];
+                const SamplePoint* columns = side_columns.data() + side * edge;
+                store(face, i, j, columns[i], side_row);
+                if (mi >= 0)
+                    store(face, mi, j, columns[mi], side_row);
+                if (mj >= 0) {
+                    store(face, i, mj, columns[i], side_mirror_row);
+                    if (mi >= 0)
+                        store(face, mi, mj, columns[mi], side_mirror_row);
+                }
+            }
+
+            // Top face texel (a, 1, b) and bottom face texel (a, -1, -b).  The top
+            // face's mirrored row points where the bottom face's row does, and
+            // the other way around, and the mirrored column negates longitude
+            outImgToXYZ(i, j, 2, edge, x, y, z, projection);
+            const float top_theta = directionLongitude(x, z);
+            const float top_phi = directionLatitude(x, y, z);
+            outImgToXYZ(i, j, 3, edge, x, y, z, projection);
+            const float bottom_theta = directionLongitude(x, z);
+
+            const SamplePoint top_column = columnHalf(top_theta);
+            const SamplePoint bottom_column = columnHalf(bottom_theta);
+            const SamplePoint top_row = rowHalf(top_phi);
+            const SamplePoint bottom_row = rowHalf(-top_phi);
+
+            store(2, i, j, top_column, top_row);
+            store(3, i, j, bottom_column, bottom_row);
+            if (mj >= 0) {
+                store(2, i, mj, bottom_column, top_row);
+                store(3, i, mj, top_column, bottom_row);
+            }
+            if (mi >= 0) {
+                const SamplePoint top_mirror_column = columnHalf(-top_theta);
+                const SamplePoint bottom_mirror_column = columnHalf(-bottom_theta);
+                store(2, mi, j, top_mirror_column, top_row);
+                store(3, mi, j, bottom_mirror_column, bottom_row);
+                if (mj >= 0) {
+                    store(2, mi, mj, bottom_mirror_column, top_row);
+                    store(3, mi, mj, top_mirror_column, bottom_row);
+                }
+            }
+        }
+    });
+
+    m_input_width = inW;
+    m_input_height = inH;
+    m_edge = edge;
+    m_layout = remapLayout(projection);
+    m_points = points;
+}
+
+bool RemapTable::load(const QString& path, int inW, int inH, int edge, CubeProjection projection) {
+
+    clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 point_bytes = static_cast<qint64>(6) * edge * edge * sizeof(SamplePoint);
+    if (m_file.size() != static_cast<qint64>(sizeof(REMAP_HEADER)) + point_bytes) {
+        m_file.close();
+        return false;
+    }
+
+    REMAP_HEADER header = {};
+    if (m_file.read(reinterpret_cast<char*>(&header), sizeof(REMAP_HEADER)) != sizeof(REMAP_HEADER) ||
+        header.dwMagic != REMAP_MAGIC ||
+        header.dwVersion != REMAP_VERSION ||
+        header.dwInputWidth != static_cast<quint32>(inW) ||
+        header.dwInputHeight != static_cast<quint32>(inH) ||
+        header.dwEdge != static_cast<quint32>(edge) ||
+        header.dwLayout != remapLayout(projection) ||
+        header.dwPointSize != sizeof(SamplePoint)) {
+        m_file.close();
+        return false;
+    }
+
+    // Map the whole file, the points start right after the header
+    m_mapping = m_file.map(0, m_file.size());
+    if (!m_mapping) {
+        m_file.close();
+        return false;
+    }
+
+    m_input_width = inW;
+    m_input_height = inH;
+    m_edge = edge;
+    m_layout = remapLayout(projection);
+    m_points = reinterpret_cast<const SamplePoint*>(m_mapping + sizeof(REMAP_HEADER));
+    return true;
+}
+
+bool RemapTable::save(const QString& path) const {
+
+    if (!isValid())
+        return false;
+
+    // QSaveFile only replaces the cache entry once it's completely written,
+    // so another process can never map a half written table
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    REMAP_HEADER header = {};
+    header.dwMagic = REMAP_MAGIC;
+    header.dwVersion = REMAP_VERSION;
+    header.dwInputWidth = m_input_width;
+    header.dwInputHeight = m_input_height;
+    header.dwEdge = m_edge;
+    header.dwLayout = m_layout;
+    header.dwPointSize = sizeof(SamplePoint);
+
+    const qint64 point_bytes = static_cast<qint64>(6) * m_edge * m_edge * sizeof(SamplePoint);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(REMAP_HEADER));
+    file.write(reinterpret_cast<const char*>(m_points), point_bytes);
+
+    return file.commit();
+}
+
+bool RemapTable::loadOrBuild(const QString& cache_dir, int inW, int inH, int edge, ThreadPool& pool,
+                             CubeProjection projection) {
+
+    // Sample points keep their rows in 16 bits
+    if (inH > SAMPLE_MAX_SOURCE_HEIGHT)
+        return false;
+
+    const QString path = QDir(cache_dir).filePath(cacheFileName(inW, inH, edge, remapLayout(projection)));
+
+    if (load(path, inW, inH, edge, projection)) {
+        std::cout << "Mapped remap table: " << path.toStdString() << std::endl;
+        return true;
+    }
+
+    std::cout << "Building remap table: " << path.toStdString() << std::endl;
+    build(inW, inH, edge, pool, projection);
+
+    // Failing to cache the table only costs the next run, this one can still use it
+    QDir().mkpath(cache_dir);
+    if (!save(path))
+        std::cerr << "Could not save remap table: " << path.toStdString() << std::endl;
+
+    return true;
+}
+
+QString RemapTable::cacheFileName(int inW, int inH, int edge, quint32 layout) {
+    return QString("remap_%1x%2_%3_%4.bin").arg(inW).arg(inH).arg(edge).arg(layout);
+}
@@ -0,0 +1,143 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef REMAP_TABLE_HPP
+#define REMAP_TABLE_HPP
+
+// C++ and STL includes
+#include <vector>
+
+// Qt includes
+#include <QFile>
+#include <QString>
+
+#include "image_to_cubemap.h"
+#include "cubemap_sampler.h"
+
+class ThreadPool;
+
+/***********************************************************************/
+
+// Use a pragma to ensure the structures are tightly packed
+#pragma pack(push, 4)
+
+// Remap table file header, followed directly by the SamplePoint array
+struct REMAP_HEADER {
+    quint32 dwMagic;
+    quint32 dwVersion;
+    quint32 dwInputWidth;
+    quint32 dwInputHeight;
+    quint32 dwEdge;
+    quint32 dwLayout;
+    quint32 dwPointSize;
+    quint32 dwReserved;
+};
+
+#pragma pack(pop)
+
+/***********************************************************************/
+
+// Remap table constants
+const quint32 REMAP_MAGIC = 0x504D5243; // "CRMP"
+const quint32 REMAP_VERSION = 1;
+
+// Unfolded layouts a table can be built for
+const quint32 REMAP_LAYOUT_CROSS = 0;
+const quint32 REMAP_LAYOUT_EAC = 1;
+
+// Layout a table of faces in the given projection is built for
+inline quint32 remapLayout(CubeProjection projection) {
+    return (projection == CubeProjection::EquiAngular) ? REMAP_LAYOUT_EAC : REMAP_LAYOUT_CROSS;
+}
+
+//
+// Precomputed source position and bilinear weights of every cube texel
+//
+// The table only depends on the input size, the face edge and the face
+// projection, so it can be
+// built once and then reused for a whole shoot.  The points are stored face by
+// face in DDS order (+X, -X, +Y, -Y, +Z, -Z), row-major within each face, and
+// the file is simply the header followed by that array in native byte order,
+// which lets a cached table be memory-mapped and used in place.
+//
+class RemapTable {
+
+public:
+
+    RemapTable() = default;
+    ~RemapTable();
+
+    RemapTable(const RemapTable&) = delete;
+    RemapTable& operator=(const RemapTable&) = delete;
+
+    // Compute the table in memory from the angles of one texel of each mirrored set, on the pool
+    void build(int inW, int inH, int edge, ThreadPool& pool, CubeProjection projection = CubeProjection::Standard);
+
+    // Memory-map a cached table, failing if it doesn't hold the requested sizes
+    bool load(const QString& path, int inW, int inH, int edge, CubeProjection projection = CubeProjection::Standard);
+
+    // Write the table out so later runs can map it
+    bool save(const QString& path) const;
+
+    // Load the cached table from cache_dir, or build it and add it to the cache,
+    // false for sources taller than SAMPLE_MAX_SOURCE_HEIGHT
+    bool loadOrBuild(const QString& cache_dir, int inW, int inH, int edge, ThreadPool& pool,
+                     CubeProjection projection = CubeProjection::Standard);
+
+    // File name a table of these sizes is cached under
+    static QString cacheFileName(int inW, int inH, int edge, quint32 layout = REMAP_LAYOUT_CROSS);
+
+    inline bool isValid(void) const {
+        return m_points != nullptr;
+    }
+
+    inline bool matches(int inW, int inH, int edge, CubeProjection projection = CubeProjection::Standard) const {
+        return isValid() && m_input_width == inW && m_input_height == inH && m_edge == edge &&
+               m_layout == remapLayout(projection);
+    }
+
+    inline int edge(void) const {
+        return m_edge;
+    }
+
+    // First point of row j of a face
+    inline const SamplePoint* row(int face, int j) const {
+        return m_points + (static_cast<qsizetype>(face) * m_edge + j) * m_edge;
+    }
+
+private:
+
+    void clear(void);
+
+    int                      m_input_width = 0;
+    int                      m_input_height = 0;
+    int                      m_edge = 0;
+    quint32                  m_layout = REMAP_LAYOUT_CROSS;
+    const SamplePoint       *m_points = nullptr;
+    std::vector<SamplePoint> m_storage;
+    QFile                    m_file;
+    uchar                   *m_mapping = nullptr;
+};
+
+#endif // REMAP_TABLE_HPP
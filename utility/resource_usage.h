@@ -0,0 +1,41 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef RESOURCE_USAGE_HPP
+#define RESOURCE_USAGE_HPP
+
+// Qt includes
+#include <QtGlobal>
+
+// Highest resident set size the process has reached so far (or since the last reset), in bytes
+qint64 peakResidentBytes(void);
+
+// Start a new peak from the current resident set size, so stages can be measured one by one.
+// Only Linux can do this, elsewhere it returns false and the peak keeps covering the whole run.
+bool resetPeakResidentBytes(void);
+
+// User plus system CPU time of every thread of the process so far, in seconds
+double processCpuSeconds(void);
+
+#endif // RESOURCE_USAGE_HPP
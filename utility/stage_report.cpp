@@ -0,0 +1,109 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+
+// Qt includes
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include "stage_report.h"
+#include "resource_usage.h"
+
+StageReport::StageReport() {
+
+    m_timer.start();
+    m_stage_cpu = processCpuSeconds();
+    resetPeakResidentBytes();
+}
+
+const StageRecord& StageReport::finish(const QString& name, qint64 bytes_in, qint64 bytes_out, int edge) {
+
+    const qint64 now = m_timer.nsecsElapsed();
+    const double cpu = processCpuSeconds();
+
+    StageRecord record;
+    record.name = name;
+    record.edge = edge;
+    record.wall_seconds = (now - m_stage_start) / 1.0e9;
+    record.cpu_seconds = cpu - m_stage_cpu;
+    record.bytes_in = bytes_in;
+    record.bytes_out = bytes_out;
+    record.peak_resident = peakResidentBytes();
+    m_stages.push_back(record);
+
+    m_stage_start = now;
+    m_stage_cpu = cpu;
+    resetPeakResidentBytes();
+
+    return m_stages.back();
+}
+
+QJsonObject StageReport::toJson(QJsonObject report) const {
+
+    QJsonArray stages;
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;
+    qint64 peak_resident = 0;
+
+    for (const StageRecord& record : m_stages) {
+
+        QJsonObject stage;
+        stage["stage"] = record.name;
+        if (record.edge > 0)
+            stage["edge"] = record.edge;
+        stage["wall_ms"] = record.wall_seconds * 1000.0;
+        stage["cpu_ms"] = record.cpu_seconds * 1000.0;
+        stage["bytes_in"] = static_cast<double>(record.bytes_in);
+        stage["bytes_out"] = static_cast<double>(record.bytes_out);
+        stage["peak_rss_mb"] = static_cast<double>(record.peak_resident) / (1024 * 1024);
+        stages.append(stage);
+
+        wall_seconds += record.wall_seconds;
+        cpu_seconds += record.cpu_seconds;
+        peak_resident = std::max(peak_resident, record.peak_resident);
+    }
+
+    // CPU time above wall time means the stage kept more than one core busy
+    QJsonObject total;
+    total["wall_ms"] = wall_seconds * 1000.0;
+    total["cpu_ms"] = cpu_seconds * 1000.0;
+    total["cores_busy"] = wall_seconds > 0.0 ? cpu_seconds / wall_seconds : 0.0;
+    total["peak_rss_mb"] = static_cast<double>(peak_resident) / (1024 * 1024);
+
+    report["stages"] = stages;
+    report["total"] = total;
+    return report;
+}
+
+bool StageReport::save(const QString& path, const QJsonObject& report) const {
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(QJsonDocument(toJson(report)).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
@@ -0,0 +1,81 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef STAGE_REPORT_HPP
+#define STAGE_REPORT_HPP
+
+// C++ and STL includes
+#include <vector>
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QString>
+
+// What one stage of a conversion took
+struct StageRecord {
+    QString name;
+    int     edge = 0;               // Face edge the stage worked on, 0 if it has none
+    double  wall_seconds = 0.0;
+    double  cpu_seconds = 0.0;      // User and system time summed over every thread
+    qint64  bytes_in = 0;           // Pixels (or file bytes) the stage read
+    qint64  bytes_out = 0;          // And what it produced
+    qint64  peak_resident = 0;      // Highest resident memory during the stage, see peakResidentBytes()
+};
+
+//
+// Wall time, CPU time, bytes and peak memory of each stage of a conversion
+//
+// Stages run back to back, so each one is measured from the end of the one
+// before (or from the report's creation) to its own finish() call.  That only
+// reads a clock and getrusage(), cheap enough to leave on for every run.
+//
+class StageReport {
+
+public:
+
+    StageReport();
+
+    // Finish the stage running since the last call, and start measuring the next one
+    const StageRecord& finish(const QString& name, qint64 bytes_in, qint64 bytes_out, int edge = 0);
+
+    inline const std::vector<StageRecord>& stages(void) const {
+        return m_stages;
+    }
+
+    // Add the stages and their totals to report, times in milliseconds and memory in MB
+    QJsonObject toJson(QJsonObject report = QJsonObject()) const;
+
+    // Write the stages along with the other fields of report to path, as indented JSON
+    bool save(const QString& path, const QJsonObject& report = QJsonObject()) const;
+
+private:
+
+    QElapsedTimer               m_timer;
+    qint64                      m_stage_start = 0;      // Nanoseconds on m_timer
+    double                      m_stage_cpu = 0.0;
+    std::vector<StageRecord>    m_stages;
+};
+
+#endif // STAGE_REPORT_HPP
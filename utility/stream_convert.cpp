@@ -0,0 +1,233 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "stream_convert.h"
+#include "strip_reader.h"
+#include "cubemap_io.h"
+#include "resource_usage.h"
+#include "dds_file.h"
+
+// A face tile and the source rows it reads
+struct StreamTile {
+    int face;
+    int x;
+    int y;
+    int first_row;
+    int last_row;
+};
+
+// Most finished tiles held at once before they are written out
+static const int STREAM_TILE_BATCH = 256;
+
+bool streamEquirectToDDS(const QString& input_path, const QString& dds_path, ThreadPool& pool, const StreamOptions& options) {
+
+    std::unique_ptr<StripReader> reader = openStripReader(input_path);
+    if (!reader) {
+        std::cerr << "Streaming needs a baseline JPEG or non-interlaced PNG: " << input_path.toStdString() << std::endl;
+        return false;
+    }
+
+    const int inW = reader->width();
+    const int inH = reader->height();
+    const int edge = cubemapEdge(inW, options.edge_percent);
+    const int tile_size = CUBEMAP_TILE_SIZE;
+
+    // Sample points store rows in 16 bits
+    if (edge <= 0 || inH <= 0 || inH > SAMPLE_MAX_SOURCE_HEIGHT) {
+        std::cerr << "Can't stream a " << inW << "x" << inH << " panorama" << std::endl;
+        return false;
+    }
+
+    std::cout << "Streaming " << inW << "x" << inH << " into " << edge << " pixel faces" << std::endl;
+
+    // Finding the rows a tile samples and sampling them must work out the same positions
+    const SphericalRowFunction spherical = options.fast_math ? sphericalRowFunction(options.kernel) : nullptr;
+
+    // 1. Find the source rows every tile samples
+    const int tiles_per_side = (edge + tile_size - 1) / tile_size;
+    const int tiles_per_face = tiles_per_side * tiles_per_side;
+    std::vector<StreamTile> tiles(6 * tiles_per_face);
+
+    pool.parallelFor(static_cast<int>(tiles.size()), [&](int index) {
+
+        StreamTile& tile = tiles[index];
+        tile.face = index / tiles_per_face;
+        tile.x = (index % tiles_per_face) % tiles_per_side * tile_size;
+        tile.y = (index % tiles_per_face) / tiles_per_side * tile_size;
+        tile.first_row = inH;
+        tile.last_row = 0;
+
+        SamplePoint points[CUBEMAP_TILE_SIZE];
+        const int i_end = std::min(tile.x + tile_size, edge);
+        const int j_end = std::min(tile.y + tile_size, edge);
+
+        for (int j = tile.y; j < j_end; ++j) {
+            computeSampleRow(tile.face, edge, inW, inH, j, tile.x, i_end, points, options.projection, spherical);
+            for (int i = 0; i < i_end - tile.x; ++i) {
+                tile.first_row = std::min(tile.first_row, static_cast<int>(points[i].v));
+                tile.last_row = std::max(tile.last_row, std::min(points[i].v + 1, inH - 1));
+            }
+        }
+    });
+
+    // Tiles become ready in the order their last row arrives
+    std::sort(tiles.begin(), tiles.end(), [](const StreamTile& a, const StreamTile& b) {
+        return a.last_row < b.last_row || (a.last_row == b.last_row && a.first_row < b.first_row);
+    });
+
+    // The first row any tile from here on still needs
+    std::vector<int> keep_from(tiles.size() + 1, inH);
+    int widest_tile = 1;
+    for (int t = static_cast<int>(tiles.size()) - 1; t >= 0; --t) {
+        keep_from[t] = std::min(keep_from[t + 1], tiles[t].first_row);
+        widest_tile = std::max(widest_tile, tiles[t].last_row - tiles[t].first_row + 1);
+    }
+
+    // 2. Split the memory budget between the row window and finished tiles
+    const qsizetype row_bytes = static_cast<qsizetype>(inW) * 4;
+    const qint64 tile_bytes = static_cast<qint64>(tile_size) * tile_size * 4;
+    const qint64 window_budget = options.memory_budget - STREAM_TILE_BATCH * tile_bytes;
+    const int window_capacity = static_cast<int>(std::min<qint64>(inH, window_budget / row_bytes));
+
+    // The window has to hold the tallest tile plus at least a small strip
+    const int min_strip = 16;
+    if (window_capacity < std::min(inH, widest_tile + min_strip)) {
+        const qint64 needed = (widest_tile + min_strip) * row_bytes + STREAM_TILE_BATCH * tile_bytes;
+        std::cerr << "Memory budget too small, this panorama needs at least "
+                  << (needed + (1 << 20) - 1) / (1 << 20) << " MB" << std::endl;
+        return false;
+    }
+
+    const int strip_rows = std::max(min_strip, window_capacity - widest_tile);
+    std::cout << "Row window of " << window_capacity << " rows, strips of " << strip_rows
+              << " rows, tallest tile spans " << widest_tile << " rows" << std::endl;
+
+    std::vector<uchar> window(static_cast<size_t>(window_capacity) * row_bytes);
+    std::vector<QRgb> finished(static_cast<size_t>(STREAM_TILE_BATCH) * tile_size * tile_size);
+
+    // 3. Lay out the DDS file, every tile is written straight to its place by the task that converted it
+    const DDS_HEADER header = makeCubemapHeader(edge, 1, options.projection);
+    const qint64 data_offset = sizeof(quint32) + sizeof(DDS_HEADER);
+    const qint64 face_bytes = static_cast<qint64>(edge) * edge * 4;
+
+    DDSFile file;
+    if (!file.open(dds_path, data_offset + 6 * face_bytes))
+        return false;
+    file.write(0, &DDS_MAGIC, sizeof(quint32));
+    file.write(sizeof(quint32), &header, sizeof(DDS_HEADER));
+
+    const SampleRowFunction sampleRow = sampleRowFunction(options.kernel);
+
+    int window_first = 0;        // Source row held at the start of the window
+    int window_end = 0;          // One past the last source row decoded
+    size_t next_tile = 0;
+    qint64 reported_percent = 0;
+
+    while (next_tile < tiles.size()) {
+
+        // Drop the rows no remaining tile reads by sliding the window down
+        const int keep = std::min(keep_from[next_tile], window_end);
+        if (keep > window_first) {
+            std::memmove(window.data(), window.data() + (keep - window_first) * row_bytes,
+                         (window_end - keep) * row_bytes);
+            window_first = keep;
+        }
+
+        // Decode the next strip, at least up to what the next tile needs
+        const int strip_end = std::min({inH, window_first + window_capacity,
+                                        std::max(window_end + strip_rows, tiles[next_tile].last_row + 1)});
+        if (strip_end > window_end) {
+            if (!reader->readRows(window.data() + (window_end - window_first) * row_bytes, row_bytes, strip_end - window_end)) {
+                std::cerr << "Failed reading rows " << window_end << " to " << strip_end << " of "
+                          << input_path.toStdString() << std::endl;
+                return false;
+            }
+            window_end = strip_end;
+        }
+
+        // Every tile whose rows are all in the window can be converted now
+        size_t ready_end = next_tile;
+        while (ready_end < tiles.size() && tiles[ready_end].last_row < window_end &&
+               ready_end - next_tile < static_cast<size_t>(STREAM_TILE_BATCH))
+            ++ready_end;
+
+        if (ready_end == next_tile) {
+            std::cerr << "Row window can't fit the next tile" << std::endl;
+            return false;
+        }
+
+        SourceView source;
+        source.bits = window.data();
+        source.stride = row_bytes;
+        source.width = inW;
+        source.height = window_end - window_first;
+
+        pool.parallelFor(static_cast<int>(ready_end - next_tile), [&](int slot) {
+
+            const StreamTile& tile = tiles[next_tile + slot];
+            const int i_end = std::min(tile.x + tile_size, edge);
+            const int j_end = std::min(tile.y + tile_size, edge);
+            QRgb* out = finished.data() + static_cast<size_t>(slot) * tile_size * tile_size;
+
+            SamplePoint points[CUBEMAP_TILE_SIZE];
+            for (int j = tile.y; j < j_end; ++j) {
+
+                // Sample points are relative to the top of the window
+                computeSampleRow(tile.face, edge, inW, inH, j, tile.x, i_end, points, options.projection, spherical);
+                for (int i = 0; i < i_end - tile.x; ++i)
+                    points[i].v = static_cast<quint16>(points[i].v - window_first);
+
+                sampleRow(source, points, i_end - tile.x, out + (j - tile.y) * tile_size);
+
+                // Then the row goes into its face
+                file.write(data_offset + tile.face * face_bytes + (static_cast<qint64>(j) * edge + tile.x) * 4,
+                           out + (j - tile.y) * tile_size, static_cast<qint64>(i_end - tile.x) * 4);
+            }
+        });
+
+        next_tile = ready_end;
+
+        // Only once per percent of the tiles, however small the batches are
+        const qint64 percent = static_cast<qint64>(next_tile) * 100 / tiles.size();
+        if (options.progress && (percent > reported_percent || next_tile == tiles.size())) {
+            (*options.progress)("stream", static_cast<qint64>(next_tile), static_cast<qint64>(tiles.size()));
+            reported_percent = percent;
+        }
+    }
+
+    if (!file.close()) {
+        std::cerr << "Failed writing " << dds_path.toStdString() << std::endl;
+        return false;
+    }
+
+    std::cout << "Peak resident memory: " << peakResidentBytes() / (1024 * 1024) << " MB (budget "
+              << options.memory_budget / (1024 * 1024) << " MB)" << std::endl;
+    return true;
+}
@@ -0,0 +1,54 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef STREAM_CONVERT_HPP
+#define STREAM_CONVERT_HPP
+
+// Qt includes
+#include <QString>
+
+#include "cubemap_convert.h"
+
+// How a panorama is streamed into a cubemap
+struct StreamOptions {
+    SampleKernel   kernel = SampleKernel::Auto;
+    CubeProjection projection = CubeProjection::Standard;
+    bool           fast_math = false;                       // Polynomial atan2 and hypot for source positions
+    int            edge_percent = 100;                      // Face edge in percent of a quarter of the width
+    qint64         memory_budget = 512LL * 1024 * 1024;     // Bytes for source rows and output tiles
+    const ProgressCallback *progress = nullptr;             // Told as tiles are written, or null
+};
+
+//
+// Convert an equirectangular JPEG or PNG straight into a DDS cubemap without
+// ever holding the whole panorama
+//
+// The source is decoded in horizontal strips.  Every face tile knows the range
+// of source rows it samples, so as soon as a strip completes a tile's range
+// the tile is converted and written to its place in the DDS file, and rows no
+// remaining tile needs are dropped.  Returns false on any error.
+//
+bool streamEquirectToDDS(const QString& input_path, const QString& dds_path, ThreadPool& pool, const StreamOptions& options);
+
+#endif // STREAM_CONVERT_HPP
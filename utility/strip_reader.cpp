@@ -0,0 +1,252 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <csetjmp>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+// JPEG and PNG decoders, both read a scanline at a time
+#include <jpeglib.h>
+#include <png.h>
+
+// Qt includes
+#include <QFileInfo>
+
+#include "strip_reader.h"
+
+/***********************************************************************/
+
+// libjpeg error handler that jumps back instead of calling exit()
+struct JpegErrorManager {
+    jpeg_error_mgr pub;
+    jmp_buf        jump;
+};
+
+static void jpegErrorExit(j_common_ptr info) {
+
+    JpegErrorManager* manager = reinterpret_cast<JpegErrorManager*>(info->err);
+    (*info->err->output_message)(info);
+    longjmp(manager->jump, 1);
+}
+
+class JpegStripReader : public StripReader {
+
+public:
+
+    ~JpegStripReader() override {
+        if (m_started)
+            jpeg_destroy_decompress(&m_info);
+        if (m_file)
+            fclose(m_file);
+    }
+
+    bool open(const QString& path, int min_width) {
+
+        m_file = fopen(path.toLocal8Bit().constData(), "rb");
+        if (!m_file)
+            return false;
+
+        m_info.err = jpeg_std_error(&m_error.pub);
+        m_error.pub.error_exit = jpegErrorExit;
+        if (setjmp(m_error.jump))
+            return false;
+
+        jpeg_create_decompress(&m_info);
+        m_started = true;
+        jpeg_stdio_src(&m_info, m_file);
+        jpeg_read_header(&m_info, TRUE);
+
+        // Scaling in the IDCT skips most of the decoding work as well as the memory
+        m_info.scale_num = 1;
+        m_info.scale_denom = jpegScaleDenominator(static_cast<int>(m_info.image_width), min_width);
+
+        // libjpeg-turbo can hand out Format_RGB32 pixels directly
+#ifdef JCS_EXTENSIONS
+        if (m_info.jpeg_color_space != JCS_CMYK && m_info.jpeg_color_space != JCS_YCCK)
+            m_info.out_color_space = JCS_EXT_BGRX;
+        else
+#endif
+            m_info.out_color_space = JCS_RGB;
+
+        jpeg_start_decompress(&m_info);
+        if (m_info.out_color_space == JCS_RGB)
+            m_row.resize(static_cast<size_t>(m_info.output_width) * 3);
+
+        return true;
+    }
+
+    int width(void) const override {
+        return static_cast<int>(m_info.output_width);
+    }
+
+    int height(void) const override {
+        return static_cast<int>(m_info.output_height);
+    }
+
+    bool readRows(uchar* dst, qsizetype stride, int count) override {
+
+        if (setjmp(m_error.jump))
+            return false;
+
+        for (int r = 0; r < count; ++r) {
+
+            uchar* out = dst + r * stride;
+
+            if (m_info.out_color_space == JCS_RGB) {
+
+                // Plain libjpeg, expand RGB to 32-bit pixels by hand
+                JSAMPROW row = m_row.data();
+                if (jpeg_read_scanlines(&m_info, &row, 1) != 1)
+                    return false;
+
+                QRgb* pixels = reinterpret_cast<QRgb*>(out);
+                for (JDIMENSION x = 0; x < m_info.output_width; ++x)
+                    pixels[x] = qRgb(m_row[3 * x], m_row[3 * x + 1], m_row[3 * x + 2]);
+            }
+            else {
+                JSAMPROW row = out;
+                if (jpeg_read_scanlines(&m_info, &row, 1) != 1)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+
+    FILE                      *m_file = nullptr;
+    jpeg_decompress_struct     m_info = {};
+    JpegErrorManager           m_error = {};
+    bool                       m_started = false;
+    std::vector<unsigned char> m_row;
+};
+
+/***********************************************************************/
+
+class PngStripReader : public StripReader {
+
+public:
+
+    ~PngStripReader() override {
+        if (m_png)
+            png_destroy_read_struct(&m_png, m_info ? &m_info : nullptr, nullptr);
+        if (m_file)
+            fclose(m_file);
+    }
+
+    bool open(const QString& path) {
+
+        m_file = fopen(path.toLocal8Bit().constData(), "rb");
+        if (!m_file)
+            return false;
+
+        m_png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        if (!m_png)
+            return false;
+        m_info = png_create_info_struct(m_png);
+        if (!m_info)
+            return false;
+
+        if (setjmp(png_jmpbuf(m_png)))
+            return false;
+
+        png_init_io(m_png, m_file);
+        png_read_info(m_png, m_info);
+
+        // Interlaced PNGs need the whole image before the first full row exists
+        if (png_get_interlace_type(m_png, m_info) != PNG_INTERLACE_NONE) {
+            std::cerr << "Interlaced PNGs can't be streamed: " << path.toStdString() << std::endl;
+            return false;
+        }
+
+        // Turn every PNG flavour into 8-bit BGRX, the Format_RGB32 memory layout
+        const int color_type = png_get_color_type(m_png, m_info);
+        png_set_expand(m_png);
+        png_set_strip_16(m_png);
+        png_set_strip_alpha(m_png);
+        if (color_type == PNG_COLOR_TYPE_GRAY || color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+            png_set_gray_to_rgb(m_png);
+        png_set_bgr(m_png);
+        png_set_filler(m_png, 0xFF, PNG_FILLER_AFTER);
+        png_read_update_info(m_png, m_info);
+
+        return true;
+    }
+
+    int width(void) const override {
+        return static_cast<int>(png_get_image_width(m_png, m_info));
+    }
+
+    int height(void) const override {
+        return static_cast<int>(png_get_image_height(m_png, m_info));
+    }
+
+    bool readRows(uchar* dst, qsizetype stride, int count) override {
+
+        if (setjmp(png_jmpbuf(m_png)))
+            return false;
+
+        for (int r = 0; r < count; ++r)
+            png_read_row(m_png, dst + r * stride, nullptr);
+
+        return true;
+    }
+
+private:
+
+    FILE       *m_file = nullptr;
+    png_structp m_png = nullptr;
+    png_infop   m_info = nullptr;
+};
+
+/***********************************************************************/
+
+int jpegScaleDenominator(int width, int min_width) {
+
+    int denominator = 1;
+    while (min_width > 0 && denominator < 8 && (width + 2 * denominator - 1) / (2 * denominator) >= min_width)
+        denominator *= 2;
+    return denominator;
+}
+
+std::unique_ptr<StripReader> openStripReader(const QString& path, int min_width) {
+
+    const QString extension = QFileInfo(path).suffix().toLower();
+
+    if (extension == "jpg" || extension == "jpeg") {
+        std::unique_ptr<JpegStripReader> reader(new JpegStripReader);
+        if (reader->open(path, min_width))
+            return reader;
+    }
+    else if (extension == "png") {
+        std::unique_ptr<PngStripReader> reader(new PngStripReader);
+        if (reader->open(path))
+            return reader;
+    }
+
+    return nullptr;
+}
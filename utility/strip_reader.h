@@ -0,0 +1,64 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef STRIP_READER_HPP
+#define STRIP_READER_HPP
+
+// C++ and STL includes
+#include <memory>
+
+// Qt includes
+#include <QtGlobal>
+#include <QString>
+
+//
+// Decodes an image from top to bottom a few rows at a time
+//
+// Rows come out as 32-bit pixels laid out like QImage::Format_RGB32, so they
+// can be sampled by the same kernels as a fully loaded image.  Only the rows
+// asked for are ever held in memory, apart from the decoder's own state.
+//
+class StripReader {
+
+public:
+
+    virtual ~StripReader() = default;
+
+    virtual int width(void) const = 0;
+    virtual int height(void) const = 0;
+
+    // Decode the next count rows into dst, one row every stride bytes
+    virtual bool readRows(uchar* dst, qsizetype stride, int count) = 0;
+};
+
+// Open a JPEG or non-interlaced PNG for strip reading, null if it can't be streamed.  A JPEG
+// is decoded at the smallest scale still at least min_width pixels wide, see jpegScaleDenominator().
+std::unique_ptr<StripReader> openStripReader(const QString& path, int min_width = 0);
+
+// libjpeg can scale a JPEG down by 2, 4 or 8 while decoding, in the IDCT itself, so
+// this is the largest of 1, 2, 4 and 8 that still gives at least min_width pixels
+// (1 for a min_width of 0)
+int jpegScaleDenominator(int width, int min_width);
+
+#endif // STRIP_READER_HPP
@@ -0,0 +1,90 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <iostream>
+#include <vector>
+
+#include "image_to_cubemap.h"
+#include "cubemap_convert.h"
+#include "fast_math.h"
+
+//
+// Checks the --fast-math source positions against the exact atan2/hypot path
+//
+// For every kernel the CPU can run, and for equirects from 1000 up to 16384
+// pixels wide, measureFastMath() (the same measurement bench_image_to_cubemap
+// reports) must find the positions of every face within fastMathErrorBound()
+// of the exact ones, and the SSE2 and AVX2 row functions must give exactly the
+// same positions and sample points as the scalar one.
+// Exits non-zero, failing the ctest run, if anything is out.
+//
+
+// Widths of the equirects checked, each twice as wide as it is tall
+static const int TEST_WIDTHS[] = { 1000, 2048, 4096, 6000, 8192, 12000, 16384 };
+
+static const SampleKernel TEST_KERNELS[] = { SampleKernel::Scalar, SampleKernel::SSE2, SampleKernel::AVX2 };
+
+// Measure every kernel for one size, false if any of them is out of bounds
+static bool checkSize(int inW, int inH, const std::vector<SampleKernel>& kernels) {
+
+    const int edge = cubemapEdge(inW);
+    const double bound_u = fastMathErrorBound(inW);
+    const double bound_v = fastMathErrorBound(inH);
+    bool passed = true;
+
+    for (SampleKernel kernel : kernels) {
+
+        const FastMathError error = measureFastMath(inW, inH, edge, kernel);
+        const bool ok = fastMathWithinBound(error, inW, inH);
+        passed = passed && ok;
+
+        std::cout << (ok ? "ok   " : "FAIL ") << inW << "x" << inH << " " << sampleKernelName(kernel)
+                  << ": max error u " << error.max_u << " px (bound " << bound_u << "), v " << error.max_v
+                  << " px (bound " << bound_v << "), " << error.kernel_mismatches << " positions and "
+                  << error.kernel_point_mismatches << " sample points of " << error.points
+                  << " differ from scalar" << std::endl;
+    }
+
+    return passed;
+}
+
+int main(void) {
+
+    // Only the kernels this CPU can run are checked
+    std::vector<SampleKernel> kernels;
+    for (SampleKernel kernel : TEST_KERNELS) {
+        if (resolveSampleKernel(kernel) == kernel)
+            kernels.push_back(kernel);
+        else
+            std::cout << "skip " << sampleKernelName(kernel) << ": not supported by this CPU" << std::endl;
+    }
+
+    bool passed = true;
+    for (int width : TEST_WIDTHS)
+        passed = checkSize(width, width / 2, kernels) && passed;
+
+    std::cout << (passed ? "All fast math positions are within bounds" : "Fast math positions are out of bounds") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+// C++ and STL includes
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Qt includes
+#include <QImage>
+
+#include "image_to_cubemap.h"
+#include "cubemap_convert.h"
+#include "remap_table.h"
+#include "thread_pool.h"
+
+//
+// Checks that a conversion gives the same faces whatever the thread count
+//
+// A small synthetic equirect is converted on one thread and on several, with
+// every kernel the CPU can run, both filters, --fast-math, a remap table and
+// both projections, from 24, 32 and 64-bit sources.  The face buffers have to
+// match byte for byte.  Exits non-zero, failing the ctest run, if any differ.
+//
+
+// Size of the synthetic equirect, a face edge of 128
+static const int TEST_WIDTH = 512;
+static const int TEST_HEIGHT = 256;
+
+// Thread counts compared against a single thread, one of them not a power of two
+static const int TEST_THREADS[] = { 3, 4 };
+
+static const SampleKernel TEST_KERNELS[] = { SampleKernel::Scalar, SampleKernel::SSE2, SampleKernel::AVX2 };
+
+static const QImage::Format TEST_FORMATS[] = { QImage::Format_RGB888, QImage::Format_RGB32, QImage::Format_RGBA64 };
+
+// Ways of working out where texels sample the source
+enum class TestPath {
+    Exact,
+    FastMath,
+    Remap,
+    Area
+};
+
+static const TestPath TEST_PATHS[] = { TestPath::Exact, TestPath::FastMath, TestPath::Remap, TestPath::Area };
+
+static const char* testPathName(TestPath path) {
+    switch (path) {
+        case TestPath::FastMath:    return "fast-math";
+        case TestPath::Remap:       return "remap";
+        case TestPath::Area:        return "area";
+        default:                    return "exact";
+    }
+}
+
+static const char* testFormatName(QImage::Format format) {
+    switch (format) {
+        case QImage::Format_RGB888: return "RGB888";
+        case QImage::Format_RGBA64: return "RGBA64";
+        default:                    return "RGB32";
+    }
+}
+
+// An equirect of hashed noise, so every texel depends on its exact taps and a
+// tile sampled from the wrong place or a row written twice shows up
+static QImage makeTestEquirect(QImage::Format format) {
+
+    QImage image(TEST_WIDTH, TEST_HEIGHT, format);
+
+    for (int y = 0; y < TEST_HEIGHT; ++y) {
+
+        uchar* row = image.scanLine(y);
+
+        for (int x = 0; x < TEST_WIDTH; ++x) {
+
+            const quint32 hash = (static_cast<quint32>(x) * 73856093u ^ static_cast<quint32>(y) * 19349663u) * 2654435761u;
+
+            if (format == QImage::Format_RGBA64) {
+                quint16* pixel = reinterpret_cast<quint16*>(row) + 4 * x;
+                pixel[0] = static_cast<quint16>(hash);
+                pixel[1] = static_cast<quint16>(hash >> 8);
+                pixel[2] = static_cast<quint16>(hash >> 16);
+                pixel[3] = 0xFFFF;
+            } else if (format == QImage::Format_RGB888) {
+                row[3 * x + 0] = static_cast<uchar>(hash >> 8);
+                row[3 * x + 1] = static_cast<uchar>(hash >> 16);
+                row[3 * x + 2] = static_cast<uchar>(hash >> 24);
+            } else {
+                reinterpret_cast<QRgb*>(row)[x] = qRgb(hash >> 8, hash >> 16, hash >> 24);
+            }
+        }
+    }
+
+    return image;
+}
+
+// Convert on a pool of threads into a face stack in DDS order, false if the conversion failed
+static bool convertOnThreads(const QImage& image_in, int threads, TestPath path, SampleKernel kernel,
+                             CubeProjection projection, QImage& faces) {
+
+    ThreadPool pool(threads);
+    const int edge = cubemapEdge(image_in.width());
+
+    // A 64-bit source keeps 16 bits per channel
+    const bool deep = image_in.depth() == 64;
+    faces = QImage(edge, 6 * edge, deep ? QImage::Format_RGBA64 : QImage::Format_RGB32);
+    std::memset(faces.bits(), 0, static_cast<size_t>(faces.bytesPerLine()) * faces.height());
+
+    FaceTargets targets;
+    targets.stride = faces.bytesPerLine();
+    targets.depth = faces.depth();
+    for (int face = 0; face < 6; ++face)
+        targets.bits[face] = faces.bits() + static_cast<qsizetype>(face) * edge * targets.stride;
+
+    // Built on the same pool, so the table is part of what's compared
+    RemapTable remap;
+    if (path == TestPath::Remap)
+        remap.build(image_in.width(), image_in.height(), edge, pool, projection);
+
+    const ProgressCallback quiet = [](const char*, qint64, qint64) {};
+
+    ConvertOptions options;
+    options.kernel = kernel;
+    options.projection = projection;
+    options.filter = (path == TestPath::Area) ? SampleFilter::Area : SampleFilter::Bilinear;
+    options.fast_math = (path == TestPath::FastMath);
+    options.remap = (path == TestPath::Remap) ? &remap : nullptr;
+    options.progress = &quiet;
+
+    return convertEquirectToFaces(image_in, targets, edge, pool, options);
+}
+
+static bool sameImage(const QImage& a, const QImage& b) {
+
+    if (a.width() != b.width() || a.height() != b.height() || a.format() != b.format())
+        return false;
+
+    const size_t row_bytes = static_cast<size_t>(a.width()) * (a.depth() / 8);
+    for (int y = 0; y < a.height(); ++y) {
+        if (std::memcmp(a.constScanLine(y), b.constScanLine(y), row_bytes) != 0)
+            return false;
+    }
+    return true;
+}
+
+int main(void) {
+
+    // Only the kernels this CPU can run are checked
+    std::vector<SampleKernel> kernels;
+    for (SampleKernel kernel : TEST_KERNELS) {
+        if (resolveSampleKernel(kernel) == kernel)
+            kernels.push_back(kernel);
+        else
+            std::cout << "skip " << sampleKernelName(kernel) << ": not supported by this CPU" << std::endl;
+    }
+
+    int failures = 0;
+    int cases = 0;
+
+    for (QImage::Format format : TEST_FORMATS) {
+
+        const QImage image_in = makeTestEquirect(format);
+
+        for (SampleKernel kernel : kernels) {
+            for (TestPath path : TEST_PATHS) {
+                for (CubeProjection projection : { CubeProjection::Standard, CubeProjection::EquiAngular }) {
+
+                    const std::string name = std::string(testFormatName(format)) + " " + sampleKernelName(kernel) + " " +
+                                             testPathName(path) + " " +
+                                             (projection == CubeProjection::EquiAngular ? "eac" : "standard");
+
+                    QImage reference;
+                    if (!convertOnThreads(image_in, 1, path, kernel, projection, reference)) {
+                        std::cout << "FAIL " << name << ": conversion on 1 thread failed" << std::endl;
+                        ++failures;
+                        continue;
+                    }
+
+                    for (int threads : TEST_THREADS) {
+
+                        ++cases;
+                        QImage faces;
+                        const bool converted = convertOnThreads(image_in, threads, path, kernel, projection, faces);
+
+                        if (!converted || !sameImage(reference, faces)) {
+                            std::cout << "FAIL " << name << ": " << threads << " threads "
+                                      << (converted ? "differ from 1 thread" : "conversion failed") << std::endl;
+                            ++failures;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << (cases - failures) << " of " << cases << " conversions match a single thread" << std::endl;
+    return (failures == 0) ? 0 : 1;
+}
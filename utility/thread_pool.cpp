@@ -0,0 +1,154 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threads) {
+
+    // Default to one thread per core
+    if (threads <= 0)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0)
+        threads = 1;
+
+    // Participant 0 is always the thread calling parallelFor()
+    for (int i = 0; i < threads; ++i)
+        m_queues.push_back(std::make_unique<WorkQueue>());
+
+    for (int i = 1; i < threads; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& task) {
+
+    if (count <= 0)
+        return;
+
+    // Nothing to share, so just run everything in order on this thread
+    if (m_workers.empty() || count == 1) {
+        for (int i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    // Deal the tasks out in contiguous runs so neighbouring tiles start on the
+    // same thread, stealing then evens out whatever imbalance is left
+    const int participants = threadCount();
+    for (int p = 0; p < participants; ++p) {
+        const int first = static_cast<int>(static_cast<long long>(count) * p / participants);
+        const int last = static_cast<int>(static_cast<long long>(count) * (p + 1) / participants);
+
+        std::lock_guard<std::mutex> lock(m_queues[p]->mutex);
+        for (int i = last - 1; i >= first; --i)
+            m_queues[p]->tasks.push_back(i);
+    }
+
+    // Wake the workers up for this batch
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_active = static_cast<int>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    // The calling thread does its share too
+    runTasks(0);
+
+    // Wait until every worker has let go of the task
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_active == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::workerLoop(int participant) {
+
+    unsigned long long seen = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen] { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+        }
+
+        runTasks(participant);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_active == 0)
+            m_done.notify_one();
+    }
+}
+
+void ThreadPool::runTasks(int participant) {
+
+    const std::function<void(int)>& task = *m_task;
+
+    int index;
+    while (popTask(participant, index) || stealTask(participant, index))
+        task(index);
+}
+
+bool ThreadPool::popTask(int participant, int& task) {
+
+    WorkQueue& queue = *m_queues[participant];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::stealTask(int participant, int& task) {
+
+    // Walk the other queues starting with our neighbour, taking the oldest task
+    const int participants = threadCount();
+    for (int offset = 1; offset < participants; ++offset) {
+        WorkQueue& victim = *m_queues[(participant + offset) % participants];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
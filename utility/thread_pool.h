@@ -0,0 +1,88 @@
+/*-----------------------------------------------------------------------------
+The MIT License
+
+Copyright © 2025-present Hillel Steinberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------*/
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+// C++ and STL includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Small work-stealing thread pool used to spread cubemap work over all cores.
+//
+// Each participant (the worker threads plus the calling thread) owns a deque of
+// task indices.  A participant pops work from the back of its own deque and, once
+// that runs dry, steals from the front of the other deques.  A pool built with a
+// single thread runs every task inline on the caller, in index order.
+//
+class ThreadPool {
+
+public:
+
+    // A thread count of 0 (or less) means one thread per hardware core
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    inline int threadCount(void) const {
+        return static_cast<int>(m_queues.size());
+    }
+
+    // Run task(0) .. task(count - 1) across the pool and wait for all of them
+    void parallelFor(int count, const std::function<void(int)>& task);
+
+private:
+
+    struct WorkQueue {
+        std::mutex      mutex;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(int participant);
+    void runTasks(int participant);
+    bool popTask(int participant, int& task);
+    bool stealTask(int participant, int& task);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread>                m_workers;
+
+    std::mutex                              m_mutex;
+    std::condition_variable                 m_wake;
+    std::condition_variable                 m_done;
+    const std::function<void(int)>         *m_task = nullptr;
+    unsigned long long                      m_generation = 0;
+    int                                     m_active = 0;
+    bool                                    m_stop = false;
+};
+
+#endif // THREAD_POOL_HPP